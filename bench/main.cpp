@@ -0,0 +1,279 @@
+// Microbenchmarks of the upload and ingest paths.
+//
+// Only a GL context is needed, it comes from the offscreen backend so the
+// benchmarks also run on CPU only machines with Mesa, for example
+//   LIBGL_ALWAYS_SOFTWARE=1 ./glviskit_bench --max 100000000 > bench.json
+// Results are written as JSON to stdout or to the file given by --output.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <glm/glm.hpp>
+#include <glviskit/gl/buffer_stack.hpp>
+#include <glviskit/render_buffer.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// with GLVISKIT_GL_TYPE=NONE only the CPU side is measured
+#if defined(GLVISKIT_USE_GL_NONE)
+#include <glviskit/null/manager.hpp>
+using BenchManager = glviskit::null::Manager;
+#else
+#include <glviskit/offscreen/manager.hpp>
+using BenchManager = glviskit::offscreen::Manager;
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// same layout as point vertices
+struct Vertex {
+    glm::vec3 position;
+    glm::vec4 color;
+    float size;
+};
+
+struct Options {
+    size_t min_elements{1000};
+    size_t max_elements{1000000};
+    std::string output;
+};
+
+struct Result {
+    std::string name;
+    std::string strategy;
+    size_t elements;
+    size_t bytes;
+    size_t iterations;
+    double min_ms;
+    double median_ms;
+};
+
+// elements processed per case, sets the number of iterations
+constexpr size_t kWorkPerCase = 50'000'000;
+
+auto ParseOptions(int argc, char **argv) -> Options {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--min") {
+            options.min_elements = std::stoull(argv[++i]);
+        } else if (i + 1 < argc && arg == "--max") {
+            options.max_elements = std::stoull(argv[++i]);
+        } else if (i + 1 < argc && arg == "--output") {
+            options.output = argv[++i];
+        } else {
+            std::cerr << "Usage: glviskit_bench [--min N] [--max N] "
+                         "[--output FILE]"
+                      << '\n';
+            exit(EXIT_FAILURE);
+        }
+    }
+    return options;
+}
+
+auto Sizes(const Options &options) -> std::vector<size_t> {
+    std::vector<size_t> sizes;
+    for (size_t n = options.min_elements; n <= options.max_elements;
+         n *= 10) {
+        sizes.push_back(n);
+    }
+    return sizes;
+}
+
+auto Iterations(size_t elements) -> size_t {
+    return std::clamp<size_t>(kWorkPerCase / elements, 3, 50);
+}
+
+auto Milliseconds(Clock::duration duration) -> double {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// run once to warm up, then time iterations, setup is not timed
+auto Measure(const std::string &name, const std::string &strategy,
+             size_t elements, size_t bytes,
+             const std::function<void()> &setup,
+             const std::function<void()> &run) -> Result {
+    size_t iterations = Iterations(elements);
+    setup();
+    run();
+
+    std::vector<double> times;
+    times.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        setup();
+        auto start = Clock::now();
+        run();
+        times.push_back(Milliseconds(Clock::now() - start));
+    }
+
+    std::sort(times.begin(), times.end());
+    std::cerr << name << "/" << strategy << " " << elements << ": "
+              << times[times.size() / 2] << " ms" << '\n';
+    return {name,       strategy,  elements, bytes, iterations, times.front(),
+            times[times.size() / 2]};
+}
+
+auto StrategyName(glviskit::UploadStrategy strategy) -> std::string {
+    switch (strategy) {
+        case glviskit::UploadStrategy::MapRange:
+            return "map_range";
+        case glviskit::UploadStrategy::Orphan:
+            return "orphan";
+        case glviskit::UploadStrategy::Persistent:
+            return "persistent";
+    }
+    return "unknown";
+}
+
+void AppendVertices(glviskit::BufferStack<Vertex> &stack, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        auto f = static_cast<float>(i);
+        stack.Append({{f, f, f}, {1.0F, 1.0F, 1.0F, 1.0F}, 1.0F});
+    }
+}
+
+// glFinish so the time includes the transfer and not only queuing it
+void BenchSync(size_t n, std::vector<Result> &results) {
+    const size_t bytes = n * sizeof(Vertex);
+    for (auto strategy : {glviskit::UploadStrategy::MapRange,
+                          glviskit::UploadStrategy::Orphan,
+                          glviskit::UploadStrategy::Persistent}) {
+        auto name = StrategyName(strategy);
+
+        // rewrite all elements of an already large enough buffer,
+        // allocated by a first sync outside of the measurement
+        glviskit::BufferStack<Vertex> stack{n, strategy};
+        AppendVertices(stack, n);
+        stack.Sync();
+        results.push_back(Measure(
+            "sync_full", name, n, bytes,
+            [&]() {
+                stack.Clear();
+                AppendVertices(stack, n);
+            },
+            [&]() {
+                stack.Sync();
+                glFinish();
+            }));
+
+        // first upload into a buffer sized up front
+        std::unique_ptr<glviskit::BufferStack<Vertex>> fresh;
+        results.push_back(Measure(
+            "sync_preallocated", name, n, bytes,
+            [&]() {
+                fresh.reset();
+                fresh = std::make_unique<glviskit::BufferStack<Vertex>>(
+                    n, strategy);
+                AppendVertices(*fresh, n);
+            },
+            [&]() {
+                fresh->Sync();
+                glFinish();
+            }));
+
+        // first upload growing from the default capacity, the difference
+        // to the preallocated case is the cost of reallocation
+        results.push_back(Measure(
+            "sync_grow", name, n, bytes,
+            [&]() {
+                fresh.reset();
+                fresh = std::make_unique<glviskit::BufferStack<Vertex>>(
+                    4, strategy);
+                AppendVertices(*fresh, n);
+            },
+            [&]() {
+                fresh->Sync();
+                glFinish();
+            }));
+    }
+}
+
+void BenchIngest(size_t n, std::vector<Result> &results) {
+    auto buffer = std::make_shared<glviskit::RenderBuffer>();
+    auto clear = [&]() { buffer->Clear(); };
+
+    results.push_back(Measure("ingest_line_to", "cpu", n, 0, clear, [&]() {
+        for (size_t i = 0; i < n; i++) {
+            auto f = static_cast<float>(i);
+            buffer->LineTo({f, f * 0.5F, 0.0F});
+        }
+        buffer->LineEnd();
+    }));
+
+    results.push_back(Measure("ingest_point", "cpu", n, 0, clear, [&]() {
+        for (size_t i = 0; i < n; i++) {
+            auto f = static_cast<float>(i);
+            buffer->Point({f, f * 0.5F, 0.0F});
+        }
+    }));
+
+    results.push_back(Measure("ingest_circle", "cpu", n, 0, clear, [&]() {
+        for (size_t i = 0; i < n; i++) {
+            auto f = static_cast<float>(i);
+            buffer->Circle({f, f * 0.5F, 0.0F});
+        }
+    }));
+}
+
+void WriteJSON(std::ostream &out, const std::vector<Result> &results) {
+    out << "{\n";
+    out << "  \"renderer\": \""
+        << reinterpret_cast<const char *>(glGetString(GL_RENDERER))
+        << "\",\n";
+    out << "  \"version\": \""
+        << reinterpret_cast<const char *>(glGetString(GL_VERSION)) << "\",\n";
+    out << "  \"persistent_mapping\": "
+        << (glviskit::PersistentMappingSupported() ? "true" : "false")
+        << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        double seconds = r.median_ms / 1000.0;
+        out << "    {\"name\": \"" << r.name << "\", \"strategy\": \""
+            << r.strategy << "\", \"elements\": " << r.elements
+            << ", \"bytes\": " << r.bytes
+            << ", \"iterations\": " << r.iterations
+            << ", \"min_ms\": " << r.min_ms
+            << ", \"median_ms\": " << r.median_ms
+            << ", \"elements_per_second\": "
+            << static_cast<double>(r.elements) / seconds
+            << ", \"bytes_per_second\": "
+            << static_cast<double>(r.bytes) / seconds << "}"
+            << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    auto options = ParseOptions(argc, argv);
+
+    // the window only provides the context
+    auto &manager = BenchManager::GetInstance();
+    auto window = manager.CreateWindow("glviskit_bench", 64, 64);
+    window->MakeCurrent();
+
+    std::vector<Result> results;
+    for (size_t n : Sizes(options)) {
+        BenchSync(n, results);
+        BenchIngest(n, results);
+    }
+
+    if (options.output.empty()) {
+        WriteJSON(std::cout, results);
+    } else {
+        std::ofstream file{options.output};
+        WriteJSON(file, results);
+    }
+    return 0;
+}
@@ -0,0 +1,409 @@
+// End-to-end scene benchmarks of the whole frame pipeline.
+//
+// Standard scenes are built at increasing scale and rendered offscreen along
+// a fixed camera flythrough, so runs are comparable between machines and
+// commits. Like glviskit_bench this only needs Mesa, for example
+//   LIBGL_ALWAYS_SOFTWARE=1 ./glviskit_scenes --max 10000000 > scenes.json
+// Every frame ends with glFinish so frame times include the GPU work.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <glm/glm.hpp>
+#include <glviskit/profiler.hpp>
+#include <glviskit/render_buffer.hpp>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// with GLVISKIT_GL_TYPE=NONE only the CPU side is measured
+#if defined(GLVISKIT_USE_GL_NONE)
+#include <glviskit/null/manager.hpp>
+using BenchManager = glviskit::null::Manager;
+using BenchWindow = glviskit::null::Window;
+#else
+#include <glviskit/offscreen/manager.hpp>
+using BenchManager = glviskit::offscreen::Manager;
+using BenchWindow = glviskit::offscreen::Window;
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr float kTwoPi = 6.28318530718F;
+
+struct Options {
+    size_t min_elements{10000};
+    size_t max_elements{1000000};
+    // vertices per polyline of the polylines scene
+    size_t line_length{1000};
+    // vertices of the shape repeated by the instances scene
+    size_t instance_vertices{64};
+    size_t frames{120};
+    int width{1280};
+    int height{720};
+    std::vector<std::string> scenes{"points", "polylines", "circles",
+                                    "instances", "sine"};
+    std::string output;
+};
+
+struct Result {
+    std::string scene;
+    size_t elements;
+    size_t frames;
+    double fps;
+    double first_frame_ms;
+    size_t first_frame_upload_bytes;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+    double upload_bytes_per_frame;
+    size_t gpu_bytes;
+};
+
+// the windows and buffers are shared by all scenes since the offscreen
+// manager keeps windows alive until exit, buffers are cleared in between
+struct Scene {
+    std::shared_ptr<BenchWindow> main;
+    // only draws the sine scene, it is skipped by render on demand otherwise
+    std::shared_ptr<BenchWindow> second;
+    std::shared_ptr<glviskit::RenderBuffer> geometry;
+    std::shared_ptr<glviskit::RenderBuffer> instanced;
+    std::shared_ptr<glviskit::RenderBuffer> sine;
+};
+
+auto Split(const std::string &list) -> std::vector<std::string> {
+    std::vector<std::string> items;
+    std::stringstream stream{list};
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+auto ParseOptions(int argc, char **argv) -> Options {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--min") {
+            options.min_elements = std::stoull(argv[++i]);
+        } else if (i + 1 < argc && arg == "--max") {
+            options.max_elements = std::stoull(argv[++i]);
+        } else if (i + 1 < argc && arg == "--line-length") {
+            options.line_length = std::max<size_t>(std::stoull(argv[++i]), 2);
+        } else if (i + 1 < argc && arg == "--instance-vertices") {
+            options.instance_vertices =
+                std::max<size_t>(std::stoull(argv[++i]), 2);
+        } else if (i + 1 < argc && arg == "--frames") {
+            options.frames = std::max<size_t>(std::stoull(argv[++i]), 1);
+        } else if (i + 2 < argc && arg == "--size") {
+            options.width = std::stoi(argv[++i]);
+            options.height = std::stoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--scenes") {
+            options.scenes = Split(argv[++i]);
+        } else if (i + 1 < argc && arg == "--output") {
+            options.output = argv[++i];
+        } else {
+            std::cerr << "Usage: glviskit_scenes [--min N] [--max N] "
+                         "[--scenes points,polylines,circles,instances,sine] "
+                         "[--line-length L] [--instance-vertices V] "
+                         "[--frames F] [--size W H] [--output FILE]"
+                      << '\n';
+            exit(EXIT_FAILURE);
+        }
+    }
+    return options;
+}
+
+auto Sizes(const Options &options) -> std::vector<size_t> {
+    std::vector<size_t> sizes;
+    for (size_t n = options.min_elements; n <= options.max_elements;
+         n *= 10) {
+        sizes.push_back(n);
+    }
+    return sizes;
+}
+
+auto Milliseconds(Clock::duration duration) -> double {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+auto Percentile(const std::vector<double> &sorted, double p) -> double {
+    auto index = static_cast<size_t>(p * static_cast<double>(sorted.size()));
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// one turn around the scene while moving in and out and up and down
+void Flythrough(glviskit::Camera &camera, size_t frame, size_t frames,
+                float direction) {
+    float t = static_cast<float>(frame) / static_cast<float>(frames);
+    float angle = kTwoPi * t;
+    camera.SetRotation({-0.5F + (0.3F * std::sin(angle)), direction * angle,
+                        0.0F});
+    camera.SetDistance(4.0F + (1.5F * std::sin(2.0F * angle)));
+}
+
+void BuildPoints(glviskit::RenderBuffer &buffer, size_t n,
+                 std::mt19937 &gen) {
+    std::uniform_real_distribution<float> dis(-1.0F, 1.0F);
+    buffer.Size(2.0F);
+    for (size_t i = 0; i < n; i++) {
+        float x = dis(gen);
+        float y = dis(gen);
+        float z = dis(gen);
+        buffer.Color({(x * 0.5F) + 0.5F, (y * 0.5F) + 0.5F, 0.8F, 1.0F});
+        buffer.Point({x, y, z});
+    }
+}
+
+// random walks, n vertices in total
+void BuildPolylines(glviskit::RenderBuffer &buffer, size_t n, size_t length,
+                    std::mt19937 &gen) {
+    std::uniform_real_distribution<float> dis(-1.0F, 1.0F);
+    const float step = 2.0F / static_cast<float>(length);
+    buffer.Size(1.5F);
+    for (size_t line = 0; line < std::max<size_t>(n / length, 1); line++) {
+        glm::vec3 p{dis(gen), dis(gen), dis(gen)};
+        buffer.Color({0.5F + (0.5F * p.x), 0.8F, 0.5F + (0.5F * p.z), 0.8F});
+        for (size_t i = 0; i < length; i++) {
+            p += step * glm::vec3{dis(gen), dis(gen), dis(gen)};
+            buffer.LineTo(p);
+        }
+        buffer.LineEnd();
+    }
+}
+
+void BuildCircles(glviskit::RenderBuffer &buffer, size_t n,
+                  std::mt19937 &gen) {
+    std::uniform_real_distribution<float> dis(-1.0F, 1.0F);
+    for (size_t i = 0; i < n; i++) {
+        buffer.Size(4.0F + (3.0F * dis(gen)));
+        buffer.Color({0.9F, 0.5F + (0.5F * dis(gen)), 0.2F, 0.7F});
+        buffer.Circle({dis(gen), dis(gen), dis(gen)});
+    }
+}
+
+// a ring with a point in the middle repeated on a cubic grid
+void BuildInstances(glviskit::RenderBuffer &buffer, size_t n,
+                    size_t vertices) {
+    buffer.Size(1.0F);
+    buffer.Color({0.3F, 0.7F, 1.0F, 1.0F});
+    for (size_t i = 0; i <= vertices; i++) {
+        float a = kTwoPi * static_cast<float>(i) /
+                  static_cast<float>(vertices);
+        buffer.LineTo({std::cos(a), std::sin(a), 0.0F});
+    }
+    buffer.LineEnd();
+    buffer.Point({0.0F, 0.0F, 0.0F});
+
+    auto side = static_cast<size_t>(std::ceil(std::cbrt(
+        static_cast<double>(n))));
+    const float spacing = 2.0F / static_cast<float>(side);
+    const glm::vec3 scale{0.4F * spacing};
+    buffer.ClearInstances();
+    for (size_t i = 0; i < n; i++) {
+        glm::vec3 cell{static_cast<float>(i % side),
+                       static_cast<float>((i / side) % side),
+                       static_cast<float>(i / (side * side))};
+        buffer.AddInstance((cell * spacing) - 1.0F + (0.5F * spacing),
+                           {0.0F, 0.0F, 0.0F}, scale);
+    }
+}
+
+// the sine of the demo, rebuilt every frame with n vertices
+void BuildSine(glviskit::RenderBuffer &buffer, size_t n, float time) {
+    buffer.Clear();
+    buffer.Size(4.0F);
+    for (size_t i = 0; i < n; i++) {
+        float x = (2.0F * static_cast<float>(i) / static_cast<float>(n)) -
+                  1.0F;
+        float y = std::sin((50.0F * x) + (10.0F * time));
+        float z = std::cos((50.0F * x) + (10.0F * time));
+        buffer.Color({(x * 0.5F) + 0.5F, (y * 0.5F) + 0.5F, 0.5F, 1.0F});
+        buffer.LineTo({x, 0.1F * y, 0.1F * z});
+    }
+    buffer.LineEnd();
+}
+
+void ResetScene(Scene &scene) {
+    scene.geometry->Clear();
+    scene.instanced->Clear();
+    scene.instanced->ClearInstances();
+    scene.sine->Clear();
+}
+
+void FinishFrame(Scene &scene) {
+    scene.main->MakeCurrent();
+    glFinish();
+    scene.second->MakeCurrent();
+    glFinish();
+}
+
+auto RunScene(Scene &scene, const Options &options, const std::string &name,
+              size_t n) -> Result {
+    auto &manager = BenchManager::GetInstance();
+    auto &profiler = glviskit::Profiler::GetInstance();
+    std::mt19937 gen{1};
+
+    ResetScene(scene);
+    std::function<void(float)> update;
+    if (name == "points") {
+        BuildPoints(*scene.geometry, n, gen);
+    } else if (name == "polylines") {
+        BuildPolylines(*scene.geometry, n, options.line_length, gen);
+    } else if (name == "circles") {
+        BuildCircles(*scene.geometry, n, gen);
+    } else if (name == "instances") {
+        BuildInstances(*scene.instanced, n, options.instance_vertices);
+    } else if (name == "sine") {
+        update = [&](float time) { BuildSine(*scene.sine, n, time); };
+    } else {
+        std::cerr << "Unknown scene: " << name << '\n';
+        exit(EXIT_FAILURE);
+    }
+
+    auto main_camera = scene.main->GetCamera();
+    auto second_camera = scene.second->GetCamera();
+    auto frame = [&](size_t index) {
+        float time = static_cast<float>(index) / 60.0F;
+        Flythrough(*main_camera, index, options.frames, 1.0F);
+        if (update) {
+            update(time);
+            Flythrough(*second_camera, index, options.frames, -1.0F);
+        }
+        manager.Render();
+        FinishFrame(scene);
+    };
+
+    // the first frame uploads static scenes, reported on its own
+    profiler.Clear();
+    auto start = Clock::now();
+    frame(0);
+    double first_frame_ms = Milliseconds(Clock::now() - start);
+    auto first = profiler.Report();
+
+    profiler.Clear();
+    std::vector<double> times;
+    times.reserve(options.frames);
+    auto run_start = Clock::now();
+    for (size_t i = 1; i <= options.frames; i++) {
+        start = Clock::now();
+        frame(i);
+        times.push_back(Milliseconds(Clock::now() - start));
+    }
+    double total_ms = Milliseconds(Clock::now() - run_start);
+    auto report = profiler.Report();
+
+    double mean = 0.0;
+    for (double t : times) {
+        mean += t;
+    }
+    mean /= static_cast<double>(times.size());
+    std::sort(times.begin(), times.end());
+
+    Result result{
+        .scene = name,
+        .elements = n,
+        .frames = options.frames,
+        .fps = static_cast<double>(options.frames) * 1000.0 / total_ms,
+        .first_frame_ms = first_frame_ms,
+        .first_frame_upload_bytes =
+            static_cast<size_t>(first.upload_bytes.max),
+        .mean_ms = mean,
+        .p50_ms = Percentile(times, 0.50),
+        .p95_ms = Percentile(times, 0.95),
+        .p99_ms = Percentile(times, 0.99),
+        .max_ms = times.back(),
+        .upload_bytes_per_frame = report.upload_bytes.mean,
+        .gpu_bytes = manager.MemoryUsage().gpu_used_bytes,
+    };
+    std::cerr << name << " " << n << ": " << result.fps << " fps, p99 "
+              << result.p99_ms << " ms" << '\n';
+    return result;
+}
+
+void WriteJSON(std::ostream &out, const Options &options,
+               const std::vector<Result> &results) {
+    out << "{\n";
+    out << "  \"renderer\": \""
+        << reinterpret_cast<const char *>(glGetString(GL_RENDERER))
+        << "\",\n";
+    out << "  \"version\": \""
+        << reinterpret_cast<const char *>(glGetString(GL_VERSION)) << "\",\n";
+    out << "  \"width\": " << options.width << ",\n";
+    out << "  \"height\": " << options.height << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        out << "    {\"scene\": \"" << r.scene
+            << "\", \"elements\": " << r.elements
+            << ", \"frames\": " << r.frames << ", \"fps\": " << r.fps
+            << ", \"first_frame_ms\": " << r.first_frame_ms
+            << ", \"first_frame_upload_bytes\": "
+            << r.first_frame_upload_bytes << ", \"mean_ms\": " << r.mean_ms
+            << ", \"p50_ms\": " << r.p50_ms << ", \"p95_ms\": " << r.p95_ms
+            << ", \"p99_ms\": " << r.p99_ms << ", \"max_ms\": " << r.max_ms
+            << ", \"upload_bytes_per_frame\": " << r.upload_bytes_per_frame
+            << ", \"gpu_bytes\": " << r.gpu_bytes << "}"
+            << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+    auto options = ParseOptions(argc, argv);
+
+    auto &manager = BenchManager::GetInstance();
+    // the second window only draws when the sine scene changes it
+    manager.SetRenderOnDemand(true);
+    glviskit::Profiler::GetInstance().SetEnabled(true);
+
+    Scene scene;
+    scene.main = manager.CreateWindow("glviskit_scenes", options.width,
+                                      options.height);
+    scene.second = manager.CreateWindow("glviskit_scenes 2", options.width,
+                                        options.height);
+    scene.geometry = manager.CreateRenderBuffer();
+    scene.instanced = manager.CreateRenderBuffer();
+    scene.sine = manager.CreateRenderBuffer();
+    scene.main->AddRenderBuffer(scene.geometry);
+    scene.main->AddRenderBuffer(scene.instanced);
+    scene.main->AddRenderBuffer(scene.sine);
+    scene.second->AddRenderBuffer(scene.sine);
+
+    for (const auto &window : {scene.main, scene.second}) {
+        auto camera = window->GetCamera();
+        camera->PerspectiveFov(60.0F, 60.0F);
+        camera->SetPreserveAspectRatio(true);
+    }
+
+    std::vector<Result> results;
+    for (const auto &name : options.scenes) {
+        for (size_t n : Sizes(options)) {
+            results.push_back(RunScene(scene, options, name, n));
+        }
+    }
+
+    scene.main->MakeCurrent();
+    if (options.output.empty()) {
+        WriteJSON(std::cout, options, results);
+    } else {
+        std::ofstream file{options.output};
+        WriteJSON(file, options, results);
+    }
+    return 0;
+}
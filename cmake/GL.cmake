@@ -25,12 +25,15 @@ elseif(GLVISKIT_GL_TYPE STREQUAL "NATIVE_GL")
     target_compile_definitions(glviskit_lib PUBLIC GLVISKIT_USE_GL_NATIVE=1)
 elseif(GLVISKIT_GL_TYPE STREQUAL "NATIVE_GLES2")
     target_compile_definitions(glviskit_lib PUBLIC GLVISKIT_USE_GLES_NATIVE=1)
+elseif(GLVISKIT_GL_TYPE STREQUAL "NONE")
+    target_compile_definitions(glviskit_lib PUBLIC GLVISKIT_USE_GL_NONE=1)
 else()
     message(FATAL_ERROR "Unknown GLVISKIT_GL_TYPE: ${GLVISKIT_GL_TYPE}")
 endif()
 
-# set source file variable
-if(GLVISKIT_GL_TYPE STREQUAL "GLAD_GL")
+# set source file variable,
+# the null backend only needs the glad function pointers
+if(GLVISKIT_GL_TYPE STREQUAL "GLAD_GL" OR GLVISKIT_GL_TYPE STREQUAL "NONE")
     list(APPEND GLVISKIT_GL_SOURCES "${CMAKE_CURRENT_SOURCE_DIR}/src/gl.c")
 elseif(GLVISKIT_GL_TYPE STREQUAL "GLAD_GLES2")
     list(APPEND GLVISKIT_GL_SOURCES "${CMAKE_CURRENT_SOURCE_DIR}/src/gles2.c")
@@ -9,6 +9,8 @@ if (NOT EMSCRIPTEN)
     set(SDL_STATIC ON CACHE BOOL "" FORCE)
     set(SDL_TEST OFF CACHE BOOL "" FORCE)
     set(SDL_STATIC_PIC ON CACHE BOOL "" FORCE)
+    # EGL based offscreen video driver used by the headless backend
+    set(SDL_OFFSCREEN ON CACHE BOOL "" FORCE)
     FetchContent_MakeAvailable(SDL3)
 
     # link SDL3 to the main library
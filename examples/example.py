@@ -65,10 +65,11 @@ while glviskit.loop():
 
     render_buffer.line
 
-    for _ in range(10):
-        render_buffer.size(np.random.uniform(1.0, 2.0))
-        render_buffer.color(np.random.uniform(0.0, 1.0, size=4))
-        render_buffer.point(np.random.uniform(-1.0, 1.0, size=3))
+    render_buffer.point(
+        np.random.uniform(-1.0, 1.0, size=(10, 3)),
+        colors=np.random.uniform(0.0, 1.0, size=(10, 4)).astype(np.float32),
+        sizes=np.random.uniform(1.0, 2.0, size=10).astype(np.float32),
+    )
 
     if frame_index % 10 == 0:
         render_buffer.color(np.random.uniform(0.0, 1.0, size=4))
@@ -79,13 +80,15 @@ while glviskit.loop():
         )
 
     render_buffer_sine.restore()
-    render_buffer_sine.color([1.0, 0.0, 0.0, 1.0])
     render_buffer_sine.size(4.0)
-    for ix in range(-1000, 1001):
-        x = ix / 1000.0
-        y = np.sin((50.0 * x) + (10 * curr_time))
-        z = np.cos((50.0 * x) + (10 * curr_time))
-
-        render_buffer_sine.color([(x * 0.5) + 0.5, (y * 0.5) + 0.5, 0.5, 1.0])
-        render_buffer_sine.line_to([20.0 * x, 1.5 * y, 1.5 * z])
+    x = np.arange(-1000, 1001) / 1000.0
+    y = np.sin((50.0 * x) + (10 * curr_time))
+    z = np.cos((50.0 * x) + (10 * curr_time))
+    colors = np.stack(
+        [(x * 0.5) + 0.5, (y * 0.5) + 0.5, np.full_like(x, 0.5), np.ones_like(x)],
+        axis=1,
+    ).astype(np.float32)
+    render_buffer_sine.line_to(
+        np.stack([20.0 * x, 1.5 * y, 1.5 * z], axis=1), colors=colors
+    )
     render_buffer_sine.line_end()
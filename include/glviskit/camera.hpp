@@ -1,9 +1,16 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <glm/fwd.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/matrix.hpp>
+#include <span>
+#include <stdexcept>
+
+#include "parallel.hpp"
+#include "transform.hpp"
 
 namespace glviskit {
 
@@ -62,6 +69,31 @@ class Camera {
         return acc;
     }
 
+    // the transform followed by the mapping of normalized device coordinates
+    // to pixels of the viewport, with the origin at the top left and y down,
+    // z stays the depth in [-1, 1]
+    [[nodiscard]] auto CalculatePixelTransform() const -> glm::mat4 {
+        glm::mat4 to_pixels{1.0F};
+        to_pixels[0][0] = viewport.x / 2.0F;
+        to_pixels[1][1] = -viewport.y / 2.0F;
+        to_pixels[3][0] = viewport.x / 2.0F;
+        to_pixels[3][1] = viewport.y / 2.0F;
+        return to_pixels * CalculateTransform();
+    }
+
+    // project world positions to pixels and depth of the viewport the camera
+    // was last rendered with, points behind the camera become NaN
+    void Project(std::span<const glm::vec3> points,
+                 std::span<glm::vec3> out) const {
+        TransformAll(CalculatePixelTransform(), points, out);
+    }
+
+    // inverse of Project, depth -1 is on the near and 1 on the far plane
+    void Unproject(std::span<const glm::vec3> pixels,
+                   std::span<glm::vec3> out) const {
+        TransformAll(glm::inverse(CalculatePixelTransform()), pixels, out);
+    }
+
     void PerspectiveFov(float hfov, float vfov, float near = 0.1F,
                         float far = 100.0F) {
         float fxn = 0.5F / tanf(glm::radians(hfov) / 2.0F);
@@ -80,27 +112,45 @@ class Camera {
         m_intrinsic[3][2] = -2.0F * far * near / (far - near);
         m_intrinsic[2][3] = -1.0F;
         aspect_ratio = fxn / fyn;
+        generation++;
     }
 
     // position, rotation, distance, viewport size getters/setters
-    void SetPosition(const glm::vec3 &position) { this->position = position; }
-    void SetRotation(const glm::vec3 &rotation) { this->rotation = rotation; }
+    void SetPosition(const glm::vec3 &position) {
+        this->position = position;
+        generation++;
+    }
+    void SetRotation(const glm::vec3 &rotation) {
+        this->rotation = rotation;
+        generation++;
+    }
     [[nodiscard]] auto GetPosition() const -> glm::vec3 { return position; }
     [[nodiscard]] auto GetRotation() const -> glm::vec3 { return rotation; }
-    void SetDistance(float distance) { this->distance = distance; }
+    void SetDistance(float distance) {
+        this->distance = distance;
+        generation++;
+    }
     [[nodiscard]] auto GetDistance() const -> float { return distance; }
+    // Set by the renderer to the size of the window it draws before every
+    // frame. Not counted in the generation, windows sharing a camera would
+    // keep invalidating each other, windows redraw on resize themselves.
     void SetViewportSize(glm::vec2 size) { viewport = size; }
     [[nodiscard]] auto GetViewportSize() const -> glm::vec2 { return viewport; }
 
     // aspect ratio preservation under viewport resize
     void SetPreserveAspectRatio(bool preserve) {
         preserve_aspect_ratio = preserve;
+        generation++;
     }
 
     [[nodiscard]] auto GetPreserveAspectRatio() const -> bool {
         return preserve_aspect_ratio;
     }
 
+    // incremented on every change affecting the transform,
+    // except the viewport size
+    [[nodiscard]] auto Generation() const -> uint64_t { return generation; }
+
     // for handling time-based updates
     void Update(float deltaTime);
 
@@ -121,6 +171,23 @@ class Camera {
     // aspect ratio preservation
     bool preserve_aspect_ratio{true};
     float aspect_ratio{1.0F};
+
+    uint64_t generation{0};
+
+    // large inputs are split across threads
+    static void TransformAll(const glm::mat4 &m,
+                             std::span<const glm::vec3> points,
+                             std::span<glm::vec3> out) {
+        if (out.size() != points.size()) {
+            throw std::invalid_argument("out must have one point per input");
+        }
+        constexpr size_t kMinPointsPerThread = 16384;
+        ParallelFor(points.size(), kMinPointsPerThread,
+                    [&](size_t begin, size_t end) {
+                        TransformPoints(m, points.data() + begin, end - begin,
+                                        out.data() + begin);
+                    });
+    }
 };
 
 }  // namespace glviskit
\ No newline at end of file
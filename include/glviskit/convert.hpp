@@ -0,0 +1,80 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace glviskit {
+
+// Convert count doubles to floats, four at a time with AVX, SSE2 or NEON
+// when the target has them. x86-64 always has SSE2 and AArch64 always has
+// NEON, AVX needs the build to enable it.
+inline void ConvertToFloat(const double *src, size_t count, float *dst) {
+    size_t i = 0;
+#if defined(__AVX__)
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        float32x2_t lo = vcvt_f32_f64(vld1q_f64(src + i));
+        vst1q_f32(dst + i, vcvt_high_f32_f64(lo, vld1q_f64(src + i + 2)));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+// IEEE 754 half precision bits to float
+inline auto HalfToFloat(uint16_t half) -> float {
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000U) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1FU;
+    const uint32_t mantissa = half & 0x3FFU;
+    if (exponent == 0) {
+        // zero or subnormal, mantissa * 2^-24
+        const float value = static_cast<float>(mantissa) * 0x1p-24F;
+        return sign != 0 ? -value : value;
+    }
+    if (exponent == 0x1F) {
+        // infinity or NaN
+        return std::bit_cast<float>(sign | 0x7F800000U | (mantissa << 13));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) |
+                                (mantissa << 13));
+}
+
+// Convert count halves to floats, four at a time with F16C or NEON when the
+// target has them. F16C needs the build to enable it.
+inline void HalfToFloat(const uint16_t *src, size_t count, float *dst) {
+    size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 4 <= count; i += 4) {
+        __m128i half =
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_ps(dst + i, _mm_cvtph_ps(half));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i,
+                  vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = HalfToFloat(src[i]);
+    }
+}
+
+}  // namespace glviskit
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "../gl/buffer_storage.hpp"
 #include "../gl/gl.hpp"
+#include "../gl/state.hpp"
 
 #include <cstddef>
 
@@ -10,16 +12,31 @@ template <typename T, GLenum TYPE = GL_ARRAY_BUFFER,
           GLenum USAGE = GL_DYNAMIC_DRAW>
 class BufferObject {
    public:
-    explicit BufferObject(size_t size)
+    // persistent buffers get immutable storage that stays mapped for
+    // writing until destruction, if persistent mapping is supported
+    explicit BufferObject(size_t size, bool persistent = false)
         : size_{size} {
         glGenBuffers(1, &buffer);
         Bind();
+#if defined(GLVISKIT_GL33)
+        if (persistent && PersistentMappingSupported()) {
+            constexpr GLbitfield flags =
+                GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            buffer_storage_proc(TYPE, size * sizeof(T), nullptr, flags);
+            mapped = static_cast<T *>(
+                glMapBufferRange(TYPE, 0, size * sizeof(T), flags));
+            Unbind();
+            return;
+        }
+#else
+        (void)persistent;
+#endif
         glBufferData(TYPE, size * sizeof(T), nullptr, USAGE);
         Unbind();
     }
 
-    // destructor
-    ~BufferObject() { glDeleteBuffers(1, &buffer); }
+    // destructor, deleting a buffer also unmaps it
+    ~BufferObject() { Delete(); }
 
     // this class is non-copyable
     BufferObject(const BufferObject &) = delete;
@@ -27,33 +44,47 @@ class BufferObject {
 
     // movable
     BufferObject(BufferObject &&other) noexcept
-        : size_(other.size_), buffer(other.buffer) {
+        : size_(other.size_), buffer(other.buffer), mapped(other.mapped) {
         other.size_ = 0;
         other.buffer = 0;
+        other.mapped = nullptr;
     }
 
     auto operator=(BufferObject &&other) noexcept -> BufferObject & {
         if (this != &other) {
-            glDeleteBuffers(1, &buffer);
+            Delete();
 
             size_ = other.size_;
             buffer = other.buffer;
+            mapped = other.mapped;
 
             other.size_ = 0;
             other.buffer = 0;
+            other.mapped = nullptr;
         }
         return *this;
     }
 
     [[nodiscard]] auto Get() const -> GLuint { return buffer; }
-    void Bind() { glBindBuffer(TYPE, buffer); }
-    void Unbind() { glBindBuffer(TYPE, 0); }
+    void Bind() { GLState::BindBuffer(TYPE, buffer); }
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    void Unbind() { GLState::ReleaseBuffer(TYPE); }
     [[nodiscard]] auto Size() const -> size_t { return size_; }
+    // persistent mapping, nullptr for regular buffers
+    [[nodiscard]] auto Mapped() const -> T * { return mapped; }
 
    private:
     size_t size_;
 
     GLuint buffer{};
+    T *mapped{nullptr};
+
+    void Delete() {
+        if (buffer != 0) {
+            GLState::ForgetBuffer(buffer);
+            glDeleteBuffers(1, &buffer);
+        }
+    }
 };
 
-}  // namespace glviskit
\ No newline at end of file
+}  // namespace glviskit
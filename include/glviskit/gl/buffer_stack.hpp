@@ -1,100 +1,187 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <span>
 #include <utility>
 #include <vector>
 
 #include "../gl/gl.hpp"
+#include "../gl/counters.hpp"
+#include "../memory.hpp"
+#include "../profiler.hpp"
+#include "../trace.hpp"
 #include "buffer_object.hpp"
 
 namespace glviskit {
 
+// how BufferStack copies new elements to the GPU
+enum class UploadStrategy : uint8_t {
+    // glMapBufferRange over the new range with invalidation
+    MapRange,
+    // orphan with glBufferData and upload with glBufferSubData
+    Orphan,
+    // copy into a persistently mapped buffer, needs GL 4.4 or
+    // ARB_buffer_storage and uses MapRange otherwise
+    Persistent,
+};
+
+#if defined(__EMSCRIPTEN__)
+inline constexpr UploadStrategy kDefaultUploadStrategy = UploadStrategy::Orphan;
+#else
+inline constexpr UploadStrategy kDefaultUploadStrategy =
+    UploadStrategy::MapRange;
+#endif
+
 template <typename T, GLenum TYPE = GL_ARRAY_BUFFER>
 class BufferStack {
    public:
-    explicit BufferStack(size_t capacity = 4) : buffer{capacity} {}
+    explicit BufferStack(size_t capacity = 4,
+                         UploadStrategy strategy = kDefaultUploadStrategy)
+        : capacity{capacity},
+          strategy{strategy},
+          buffer{MakeStorage(capacity, strategy)} {}
+
+    ~BufferStack() { DeleteFences(); }
 
-    void Append(const T &element) { elements.push_back(element); }
+    // this class is non-copyable and owns its fences
+    BufferStack(const BufferStack &) = delete;
+    auto operator=(const BufferStack &) -> BufferStack & = delete;
+    BufferStack(BufferStack &&) = delete;
+    auto operator=(BufferStack &&) -> BufferStack & = delete;
+
+    void Append(const T &element) {
+        elements.push_back(element);
+        generation++;
+    }
+
+    // append count default constructed elements to be filled in place,
+    // the span is invalidated by the next append
+    auto Extend(size_t count) -> std::span<T> {
+        const size_t begin = elements.size();
+        elements.resize(begin + count);
+        generation++;
+        return {elements.data() + begin, count};
+    }
+
+    // overwrite count existing elements from begin in place, the range is
+    // uploaded again on the next sync, the span is invalidated by the next
+    // append
+    auto Overwrite(size_t begin, size_t count) -> std::span<T> {
+        size = (std::min)(size, begin);
+        generation++;
+        return {elements.data() + begin, count};
+    }
 
     auto Sync() -> bool {
         // check is there anything to sync
-        if (size == elements.size()) {
+        if (size == elements.size() && !recreate) {
             return false;
         }
 
-        // check if we need to reallocate
+        ScopedTimer timer{Profiler::Stage::Sync};
+        TraceScope trace{"BufferStack::Sync"};
+        const size_t upload_bytes = (elements.size() - size) * sizeof(T);
+        Profiler::GetInstance().AddUploadBytes(upload_bytes);
+
+        // storage type changed with the upload strategy
         bool reallocated = false;
-        if (elements.size() > buffer.Size()) {
+        if (recreate) {
+            DeleteFences();
+            buffer = MakeStorage(capacity, strategy);
+            segment = 0;
+            written = 0;
+            recreate = false;
+            reallocated = true;
+            storage++;
+        }
+
+        // check if we need to reallocate
+        if (elements.size() > capacity) {
             // double the capacity until it fits
-            size_t new_capacity = buffer.Size();
+            size_t new_capacity = capacity;
             while (elements.size() > new_capacity) {
                 new_capacity *= 2;
             }
 
             // create new buffer object with new capacity
             // and get old buffer object for data copy
+            const size_t offset = Offset();
             auto old_buffer =
-                std::exchange(buffer, BufferObject<T, TYPE>(new_capacity));
+                std::exchange(buffer, MakeStorage(new_capacity, strategy));
 
             // copy old data
             glBindBuffer(GL_COPY_READ_BUFFER, old_buffer.Get());
             glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.Get());
-            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
-                                size * sizeof(T));
+            GLVISKIT_COUNT_GL(buffer_binds, 2);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                offset * sizeof(T), 0, size * sizeof(T));
             glBindBuffer(GL_COPY_READ_BUFFER, 0);
             glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
+            // the old storage is released once the GPU is done with it
+            DeleteFences();
+            capacity = new_capacity;
+            segment = 0;
+            written = size;
             reallocated = true;
+            storage++;
+        } else if (buffer.Mapped() != nullptr && size < written) {
+            NextSegment();
         }
 
-        // map the rest of the buffer and copy new data
-        buffer.Bind();
-
-#if defined(__EMSCRIPTEN__)
-        // slower emscripten compatible but slower
-        // orphan the buffer if we are writing the whole buffer
-        if (size == 0) {
-            glBufferData(TYPE, buffer.Size() * sizeof(T), nullptr,
-                         GL_STREAM_DRAW);
-        }
-
-        glBufferSubData(TYPE, size * sizeof(T),
-                        (elements.size() - size) * sizeof(T),
-                        elements.data() + size);
-
-#else
-        // fast but not emscripten compatible
-        GLbitfield flags = GL_MAP_WRITE_BIT;
-        // invalidate if we are writing the whole buffer
-        if (size == 0) {
-            flags |= GL_MAP_INVALIDATE_BUFFER_BIT;
+        if (buffer.Mapped() != nullptr) {
+            // coherent mapping, no flush or unmap needed
+            std::copy(elements.data() + size,
+                      elements.data() + elements.size(),
+                      buffer.Mapped() + Offset() + size);
+        } else if (strategy == UploadStrategy::Orphan) {
+            UploadOrphan();
         } else {
-            flags |= GL_MAP_INVALIDATE_RANGE_BIT;
+            UploadMapRange();
         }
-        void *ptr =
-            glMapBufferRange(TYPE, size * sizeof(T),
-                             (elements.size() - size) * sizeof(T), flags);
-        std::copy(elements.data() + size, elements.data() + elements.size(),
-                  static_cast<T *>(ptr));
-        glUnmapBuffer(TYPE);
-#endif
-
-        buffer.Unbind();
 
+        GLVISKIT_COUNT_GL(uploaded_bytes, upload_bytes);
         size = elements.size();
+        written = (std::max)(written, size);
         return reallocated;
     }
 
+    // Persistent falls back to MapRange where persistent mapping is not
+    // supported, and WebGL only supports Orphan
+    void SetUploadStrategy(UploadStrategy new_strategy) {
+        if (new_strategy == strategy) {
+            return;
+        }
+        // switching to or from persistent needs a different kind of storage
+        if (new_strategy == UploadStrategy::Persistent ||
+            strategy == UploadStrategy::Persistent) {
+            recreate = true;
+            size = 0;
+        }
+        strategy = new_strategy;
+    }
+    [[nodiscard]] auto GetUploadStrategy() const -> UploadStrategy {
+        return strategy;
+    }
+
     void Save() { restore_point = elements.size(); }
 
     void Restore() {
+        if (elements.size() != restore_point) {
+            generation++;
+        }
         elements.resize(restore_point);
 
         size = (std::min)(size, restore_point);
     }
 
     void Clear() {
+        if (!elements.empty()) {
+            generation++;
+        }
         elements.clear();
         size = 0;
     }
@@ -103,15 +190,143 @@ class BufferStack {
     void Bind() { buffer.Bind(); }
     void Unbind() { buffer.Unbind(); }
 
-    [[nodiscard]] auto Capacity() const -> size_t { return buffer.Size(); }
+    [[nodiscard]] auto Capacity() const -> size_t { return capacity; }
     [[nodiscard]] auto Size() const -> size_t { return elements.size(); }
+    // first element of the segment the GPU reads, always 0 unless the
+    // buffer is persistently mapped
+    [[nodiscard]] auto Offset() const -> size_t { return segment * capacity; }
+    // incremented whenever the elements move to new storage or another
+    // segment, vertex arrays pointing into the buffer need to be configured
+    // again
+    [[nodiscard]] auto Storage() const -> uint64_t { return storage; }
+    // incremented on every change of the CPU side contents
+    [[nodiscard]] auto Generation() const -> uint64_t { return generation; }
+    [[nodiscard]] auto Elements() const -> std::span<const T> {
+        return elements;
+    }
+
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        auto report = VectorMemory(elements);
+        report.gpu_used_bytes = size * sizeof(T);
+        report.gpu_reserved_bytes = buffer.Size() * sizeof(T);
+        report.buffer_objects = 1;
+        return report;
+    }
 
    private:
+    // a persistently mapped buffer is written without synchronization, so
+    // its storage is split into segments of capacity elements each and
+    // rewriting a range the GPU may still read continues in the next one
+    static constexpr size_t kSegments = 3;
+
     size_t size{};
+    // high water mark of the current segment, for persistent mapping
+    size_t written{};
+    size_t capacity;
+    size_t segment{};
+    // signaled once the GPU no longer reads the segment
+    std::array<GLsync, kSegments> fences{};
+    uint64_t storage{};
     size_t restore_point{};
+    UploadStrategy strategy{kDefaultUploadStrategy};
+    bool recreate{false};
+    uint64_t generation{};
     std::vector<T> elements;
 
     BufferObject<T, TYPE> buffer;
+
+    static auto MakeStorage(size_t capacity, UploadStrategy strategy)
+        -> BufferObject<T, TYPE> {
+        const bool persistent = strategy == UploadStrategy::Persistent;
+        const size_t segments =
+            persistent && PersistentMappingSupported() ? kSegments : 1;
+        return BufferObject<T, TYPE>(capacity * segments, persistent);
+    }
+
+    // switch to the next segment once the GPU is done with it, and copy
+    // the elements that stay unchanged over on the GPU
+    void NextSegment() {
+        const size_t from = Offset();
+        // every draw reading the current segment was submitted before this
+        fences.at(segment) = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        segment = (segment + 1) % kSegments;
+        WaitFence(fences.at(segment));
+
+        if (size > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer.Get());
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.Get());
+            GLVISKIT_COUNT_GL(buffer_binds, 2);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                from * sizeof(T), Offset() * sizeof(T),
+                                size * sizeof(T));
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+
+        written = size;
+        storage++;
+    }
+
+    static void WaitFence(GLsync &fence) {
+        if (fence == nullptr) {
+            return;
+        }
+        TraceScope trace{"BufferStack::WaitFence"};
+        constexpr GLuint64 kTimeout = 1000000000;  // 1 s
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kTimeout) ==
+               GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    void DeleteFences() {
+        for (auto &fence : fences) {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+    }
+
+    // orphan the buffer if we are writing the whole buffer,
+    // then upload with glBufferSubData, the only way that works on WebGL
+    void UploadOrphan() {
+        buffer.Bind();
+        if (size == 0) {
+            glBufferData(TYPE, buffer.Size() * sizeof(T), nullptr,
+                         GL_STREAM_DRAW);
+        }
+
+        glBufferSubData(TYPE, size * sizeof(T),
+                        (elements.size() - size) * sizeof(T),
+                        elements.data() + size);
+        buffer.Unbind();
+    }
+
+    // map the rest of the buffer and copy new data
+    void UploadMapRange() {
+#if defined(__EMSCRIPTEN__)
+        // WebGL cannot map buffers
+        UploadOrphan();
+#else
+        buffer.Bind();
+        GLbitfield flags = GL_MAP_WRITE_BIT;
+        // invalidate if we are writing the whole buffer
+        if (size == 0) {
+            flags |= GL_MAP_INVALIDATE_BUFFER_BIT;
+        } else {
+            flags |= GL_MAP_INVALIDATE_RANGE_BIT;
+        }
+        void *ptr =
+            glMapBufferRange(TYPE, size * sizeof(T),
+                             (elements.size() - size) * sizeof(T), flags);
+        std::copy(elements.data() + size, elements.data() + elements.size(),
+                  static_cast<T *>(ptr));
+        glUnmapBuffer(TYPE);
+        buffer.Unbind();
+#endif
+    }
 };
 
 }  // namespace glviskit
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstring>
+
+#include "../gl/gl.hpp"
+
+// NOLINTBEGIN
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+#if defined(GLAD_API_PTR)
+#define GLVISKIT_APIENTRY GLAD_API_PTR
+#elif defined(APIENTRY)
+#define GLVISKIT_APIENTRY APIENTRY
+#else
+#define GLVISKIT_APIENTRY
+#endif
+// NOLINTEND
+
+namespace glviskit {
+
+// glBufferStorage is GL 4.4 or ARB_buffer_storage and not part of the 3.3
+// core functions glad loads, so it is looked up separately after context
+// creation. Persistent mapping is only used when it was found.
+using BufferStorageProc = void(GLVISKIT_APIENTRY *)(GLenum target,
+                                                    GLsizeiptr size,
+                                                    const void *data,
+                                                    GLbitfield flags);
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+inline BufferStorageProc buffer_storage_proc = nullptr;
+
+[[nodiscard]] inline auto PersistentMappingSupported() -> bool {
+    return buffer_storage_proc != nullptr;
+}
+
+// look up glBufferStorage with the given loader if the current context
+// supports it, must be called with a current context
+template <typename F>
+void LoadBufferStorage(F get_proc_address) {
+#if defined(GLVISKIT_GL33)
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool supported = major > 4 || (major == 4 && minor >= 4);
+
+    GLint num_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+    for (GLint i = 0; !supported && i < num_extensions; i++) {
+        const auto *name = reinterpret_cast<const char *>(
+            glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        supported = name != nullptr &&
+                    std::strcmp(name, "GL_ARB_buffer_storage") == 0;
+    }
+
+    if (supported) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        buffer_storage_proc = reinterpret_cast<BufferStorageProc>(
+            get_proc_address("glBufferStorage"));
+    }
+#else
+    (void)get_proc_address;
+#endif
+}
+
+}  // namespace glviskit
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// GL debugging is on in builds without NDEBUG,
+// define GLVISKIT_GL_DEBUG to 0 or 1 to override
+#if !defined(GLVISKIT_GL_DEBUG)
+#if defined(NDEBUG)
+#define GLVISKIT_GL_DEBUG 0
+#else
+#define GLVISKIT_GL_DEBUG 1
+#endif
+#endif
+
+// call counting follows GLVISKIT_GL_DEBUG unless defined explicitly
+#if !defined(GLVISKIT_GL_COUNTERS)
+#define GLVISKIT_GL_COUNTERS GLVISKIT_GL_DEBUG
+#endif
+
+namespace glviskit {
+
+// GL calls issued by glviskit during a frame.
+struct GLCallCounts {
+    uint64_t draw_calls{0};
+    uint64_t buffer_binds{0};
+    uint64_t program_switches{0};
+    uint64_t uploaded_bytes{0};
+    // binds and program switches skipped by the state cache
+    uint64_t elided_calls{0};
+};
+
+// Counts GL calls at the places glviskit issues them. Compiled out unless
+// GLVISKIT_GL_COUNTERS is set, in which case all counts stay zero.
+class GLCallCounter {
+   public:
+    static constexpr bool kEnabled = GLVISKIT_GL_COUNTERS != 0;
+
+    // singleton access
+    static auto GetInstance() -> GLCallCounter & {
+        static GLCallCounter instance;
+        return instance;
+    }
+
+    GLCallCounter(const GLCallCounter &) = delete;
+    auto operator=(const GLCallCounter &) -> GLCallCounter & = delete;
+    GLCallCounter(GLCallCounter &&) = delete;
+    auto operator=(GLCallCounter &&) -> GLCallCounter & = delete;
+    ~GLCallCounter() = default;
+
+    auto Current() -> GLCallCounts & { return current; }
+
+    // publish the counts of the finished frame and start a new one
+    void EndFrame() {
+        last = current;
+        current = GLCallCounts{};
+    }
+
+    // counts of the last finished frame
+    [[nodiscard]] auto LastFrame() const -> GLCallCounts { return last; }
+
+   private:
+    GLCallCounts current;
+    GLCallCounts last;
+
+    GLCallCounter() = default;
+};
+
+}  // namespace glviskit
+
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+#if GLVISKIT_GL_COUNTERS
+#define GLVISKIT_COUNT_GL(counter, n) \
+    (::glviskit::GLCallCounter::GetInstance().Current().counter += (n))
+#else
+#define GLVISKIT_COUNT_GL(counter, n) ((void)0)
+#endif
+// NOLINTEND(cppcoreguidelines-macro-usage)
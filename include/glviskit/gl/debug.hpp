@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../gl/buffer_storage.hpp"
+#include "../gl/counters.hpp"
+#include "../gl/gl.hpp"
+
+// NOLINTBEGIN
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#endif
+#ifndef GL_DEBUG_OUTPUT_SYNCHRONOUS
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#endif
+#ifndef GL_DEBUG_TYPE_ERROR
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#endif
+#ifndef GL_DEBUG_SEVERITY_HIGH
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#endif
+#ifndef GL_DEBUG_SEVERITY_MEDIUM
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#endif
+#ifndef GL_DEBUG_SEVERITY_LOW
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#endif
+#ifndef GL_DEBUG_SEVERITY_NOTIFICATION
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#endif
+// NOLINTEND
+
+namespace glviskit {
+
+// KHR_debug is GL 4.3 and GLES 3.2 core and not among the loaded functions,
+// so glDebugMessageCallback is looked up like glBufferStorage. When it is
+// missing debug builds fall back to polling glGetError once per frame,
+// release builds never check for errors.
+using DebugMessageProc = void(GLVISKIT_APIENTRY *)(GLenum source, GLenum type,
+                                                   GLuint id, GLenum severity,
+                                                   GLsizei length,
+                                                   const GLchar *message,
+                                                   const void *user_param);
+using DebugMessageCallbackProc = void(GLVISKIT_APIENTRY *)(
+    DebugMessageProc callback, const void *user_param);
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+inline DebugMessageCallbackProc debug_message_callback_proc = nullptr;
+
+// look up glDebugMessageCallback if the current context supports KHR_debug
+template <typename F>
+void LoadDebugOutput(F get_proc_address) {
+#if GLVISKIT_GL_DEBUG && !defined(__EMSCRIPTEN__)
+    GLint num_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+    bool supported = false;
+    for (GLint i = 0; !supported && i < num_extensions; i++) {
+        const auto *name = reinterpret_cast<const char *>(
+            glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        supported = name != nullptr && std::strcmp(name, "GL_KHR_debug") == 0;
+    }
+    if (!supported) {
+        return;
+    }
+
+    // desktop GL exports the core name, GLES the suffixed one
+    for (const char *name :
+         {"glDebugMessageCallback", "glDebugMessageCallbackKHR"}) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto proc = reinterpret_cast<DebugMessageCallbackProc>(
+            get_proc_address(name));
+        if (proc != nullptr) {
+            debug_message_callback_proc = proc;
+            return;
+        }
+    }
+#else
+    (void)get_proc_address;
+#endif
+}
+
+inline void GLVISKIT_APIENTRY DebugMessage(GLenum /*source*/, GLenum type,
+                                           GLuint id, GLenum severity,
+                                           GLsizei /*length*/,
+                                           const GLchar *message,
+                                           const void * /*user_param*/) {
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION) {
+        return;
+    }
+    std::cerr << (type == GL_DEBUG_TYPE_ERROR ? "OpenGL error " : "OpenGL ")
+              << id << ": " << message << '\n';
+}
+
+// debug output is per context state,
+// must be called once for every context with the context current
+inline void EnableDebugOutput() {
+#if GLVISKIT_GL_DEBUG
+    if (debug_message_callback_proc == nullptr) {
+        return;
+    }
+    glEnable(GL_DEBUG_OUTPUT);
+    // report on the thread and call that caused the message
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    debug_message_callback_proc(DebugMessage, nullptr);
+#endif
+}
+
+// exit on GL errors in debug builds without debug output,
+// glGetError can stall the pipeline so this is skipped otherwise
+inline void CheckGLError(const char *where) {
+#if GLVISKIT_GL_DEBUG
+    if (debug_message_callback_proc != nullptr) {
+        return;
+    }
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        std::cerr << "OpenGL error " << where << ": " << error << '\n';
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void)where;
+#endif
+}
+
+}  // namespace glviskit
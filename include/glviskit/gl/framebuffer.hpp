@@ -0,0 +1,158 @@
+#pragma once
+
+#include "../gl/gl.hpp"
+
+namespace glviskit {
+
+class Texture {
+   public:
+    Texture() { glGenTextures(1, &texture); }
+
+    // destructor
+    ~Texture() { glDeleteTextures(1, &texture); }
+
+    // this class is non-copyable
+    Texture(const Texture &) = delete;
+    auto operator=(const Texture &) -> Texture & = delete;
+
+    // but movable
+    Texture(Texture &&other) noexcept : texture{other.texture} {
+        other.texture = 0;
+    }
+
+    auto operator=(Texture &&other) noexcept -> Texture & {
+        if (this != &other) {
+            glDeleteTextures(1, &texture);
+
+            texture = other.texture;
+
+            other.texture = 0;
+        }
+        return *this;
+    }
+
+    // (re)allocate 2D storage without mipmaps, contents are undefined
+    void Allocate(GLint internal_format, GLenum format, GLenum type, int width,
+                  int height) {
+        Bind();
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0,
+                     format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        Unbind();
+    }
+
+    [[nodiscard]] auto Get() const -> GLuint { return texture; }
+    void Bind() const { glBindTexture(GL_TEXTURE_2D, texture); }
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    void Unbind() const { glBindTexture(GL_TEXTURE_2D, 0); }
+
+   private:
+    GLuint texture{};
+};
+
+class Renderbuffer {
+   public:
+    Renderbuffer() { glGenRenderbuffers(1, &renderbuffer); }
+
+    // destructor
+    ~Renderbuffer() { glDeleteRenderbuffers(1, &renderbuffer); }
+
+    // this class is non-copyable
+    Renderbuffer(const Renderbuffer &) = delete;
+    auto operator=(const Renderbuffer &) -> Renderbuffer & = delete;
+
+    // but movable
+    Renderbuffer(Renderbuffer &&other) noexcept
+        : renderbuffer{other.renderbuffer} {
+        other.renderbuffer = 0;
+    }
+
+    auto operator=(Renderbuffer &&other) noexcept -> Renderbuffer & {
+        if (this != &other) {
+            glDeleteRenderbuffers(1, &renderbuffer);
+
+            renderbuffer = other.renderbuffer;
+
+            other.renderbuffer = 0;
+        }
+        return *this;
+    }
+
+    // (re)allocate storage, samples of 0 means no multisampling
+    void Allocate(GLenum internal_format, int width, int height,
+                  int samples = 0) {
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+                                         internal_format, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+
+    [[nodiscard]] auto Get() const -> GLuint { return renderbuffer; }
+
+   private:
+    GLuint renderbuffer{};
+};
+
+class Framebuffer {
+   public:
+    Framebuffer() { glGenFramebuffers(1, &framebuffer); }
+
+    // destructor
+    ~Framebuffer() { glDeleteFramebuffers(1, &framebuffer); }
+
+    // this class is non-copyable
+    Framebuffer(const Framebuffer &) = delete;
+    auto operator=(const Framebuffer &) -> Framebuffer & = delete;
+
+    // but movable
+    Framebuffer(Framebuffer &&other) noexcept : framebuffer{other.framebuffer} {
+        other.framebuffer = 0;
+    }
+
+    auto operator=(Framebuffer &&other) noexcept -> Framebuffer & {
+        if (this != &other) {
+            glDeleteFramebuffers(1, &framebuffer);
+
+            framebuffer = other.framebuffer;
+
+            other.framebuffer = 0;
+        }
+        return *this;
+    }
+
+    // attachments are made to the currently bound framebuffer
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    void Attach(GLenum attachment, const Texture &texture) const {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D,
+                               texture.Get(), 0);
+    }
+
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    void Attach(GLenum attachment, const Renderbuffer &renderbuffer) const {
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER,
+                                  renderbuffer.Get());
+    }
+
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    [[nodiscard]] auto Complete() const -> bool {
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+               GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    [[nodiscard]] auto Get() const -> GLuint { return framebuffer; }
+    void Bind(GLenum target = GL_FRAMEBUFFER) const {
+        glBindFramebuffer(target, framebuffer);
+    }
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    void Unbind(GLenum target = GL_FRAMEBUFFER) const {
+        glBindFramebuffer(target, 0);
+    }
+
+   private:
+    GLuint framebuffer{};
+};
+
+}  // namespace glviskit
@@ -15,6 +15,10 @@
 #elif defined(GLVISKIT_USE_GLES_NATIVE)
 #include <GLES3/gl3.h>
 #define GLVISKIT_GLES3
+#elif defined(GLVISKIT_USE_GL_NONE)
+// glad only provides the function pointers, see null.hpp
+#include "../glad/gl.h"
+#define GLVISKIT_GL33
 #else
 #include "../glad/gl.h"
 #define GLVISKIT_GL33
@@ -3,7 +3,9 @@
 #include <glm/glm.hpp>
 
 #include "buffer_stack.hpp"
+#include "../gl/counters.hpp"
 #include "../gl/gl.hpp"
+#include "../memory.hpp"
 
 namespace glviskit {
 
@@ -13,4 +15,40 @@ struct Instance {
 
 using InstanceBuffer = BufferStack<Instance, GL_ARRAY_BUFFER>;
 
+// draw every index of ebo once per instance, reading vertices and indices
+// from the segments of the buffers the GPU currently reads
+template <typename V>
+void DrawElementsInstanced(
+    GLenum mode, const BufferStack<V> &vbo,
+    const BufferStack<GLuint, GL_ELEMENT_ARRAY_BUFFER> &ebo,
+    const InstanceBuffer &vbo_inst) {
+    const auto count = static_cast<GLsizei>(ebo.Size());
+    const auto instances = static_cast<GLsizei>(vbo_inst.Size());
+    // NOLINTNEXTLINE(performance-no-int-to-ptr)
+    const auto *indices = (const void *)(ebo.Offset() * sizeof(GLuint));
+#if defined(GLVISKIT_GL33)
+    glDrawElementsInstancedBaseVertex(mode, count, GL_UNSIGNED_INT, indices,
+                                      instances,
+                                      static_cast<GLint>(vbo.Offset()));
+#else
+    // segments are only used with persistent mapping, so no base vertex
+    (void)vbo;
+    glDrawElementsInstanced(mode, count, GL_UNSIGNED_INT, indices, instances);
+#endif
+    GLVISKIT_COUNT_GL(draw_calls, 1);
+}
+
+// vertices, indices and vertex arrays of a primitive buffer, the shared
+// instance buffer is accounted by its owner
+template <typename V, typename VAOs>
+[[nodiscard]] auto PrimitiveMemory(
+    const BufferStack<V> &vbo,
+    const BufferStack<GLuint, GL_ELEMENT_ARRAY_BUFFER> &ebo, const VAOs &vaos)
+    -> MemoryReport {
+    MemoryReport report = vbo.MemoryUsage();
+    report += ebo.MemoryUsage();
+    report.vertex_arrays += vaos.size();
+    return report;
+}
+
 }  // namespace glviskit
\ No newline at end of file
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "../gl/gl.hpp"
+
+namespace glviskit {
+
+// What the null GL backend has seen, call counts since the last Reset.
+struct NullGLStats {
+    uint64_t calls{0};
+    uint64_t draw_calls{0};
+    // vertices or indices drawn, times the instance count
+    uint64_t drawn_vertices{0};
+    uint64_t uploaded_bytes{0};
+    // live buffer objects and their allocated size
+    uint64_t buffers{0};
+    uint64_t buffer_bytes{0};
+    uint64_t peak_buffer_bytes{0};
+};
+
+// GL implementation for GLVISKIT_GL_TYPE=NONE that needs no driver.
+// Load points the glad function pointers at stubs that only record buffer
+// sizes, uploads and draws, so the CPU side of glviskit can be profiled on
+// machines without GL. Object names are never reused, every query succeeds
+// and mapped ranges point to scratch memory that is read back as zeros.
+// Only the functions glviskit calls are stubbed, the others stay null.
+class NullGL {
+   public:
+    // singleton access
+    static auto GetInstance() -> NullGL & {
+        static NullGL instance;
+        return instance;
+    }
+
+    NullGL(const NullGL &) = delete;
+    auto operator=(const NullGL &) -> NullGL & = delete;
+    NullGL(NullGL &&) = delete;
+    auto operator=(NullGL &&) -> NullGL & = delete;
+    ~NullGL() = default;
+
+    [[nodiscard]] auto Stats() const -> const NullGLStats & { return stats; }
+
+    // reset the call counts, live buffers are kept
+    void Reset() {
+        stats.calls = 0;
+        stats.draw_calls = 0;
+        stats.drawn_vertices = 0;
+        stats.uploaded_bytes = 0;
+        stats.peak_buffer_bytes = stats.buffer_bytes;
+    }
+
+    static void Load();
+
+   private:
+    NullGLStats stats;
+    GLuint next_name{1};
+    std::unordered_map<GLenum, GLuint> bound;
+    std::unordered_map<GLuint, size_t> buffer_sizes;
+    // one mapping per target at a time, like real GL
+    std::unordered_map<GLenum, std::vector<uint8_t>> mapped;
+
+    NullGL() = default;
+
+    // every stub goes through here to be counted
+    static auto Call() -> NullGL & {
+        auto &gl = GetInstance();
+        gl.stats.calls++;
+        return gl;
+    }
+
+    static void Gen(GLsizei n, GLuint *names) {
+        auto &gl = Call();
+        for (GLsizei i = 0; i < n; i++) {
+            names[i] = gl.next_name++;
+        }
+    }
+
+    static void Delete(GLsizei /*n*/, const GLuint * /*names*/) { Call(); }
+
+    void Draw(GLsizei count, GLsizei instances) {
+        stats.draw_calls++;
+        stats.drawn_vertices += static_cast<uint64_t>(count) *
+                                static_cast<uint64_t>(instances);
+    }
+
+    void Allocate(GLenum target, GLsizeiptr size) {
+        auto &current = buffer_sizes[bound[target]];
+        stats.buffer_bytes -= current;
+        current = static_cast<size_t>(size);
+        stats.buffer_bytes += current;
+        if (stats.buffer_bytes > stats.peak_buffer_bytes) {
+            stats.peak_buffer_bytes = stats.buffer_bytes;
+        }
+    }
+
+    void DeleteBuffers(GLsizei n, const GLuint *names) {
+        for (GLsizei i = 0; i < n; i++) {
+            auto it = buffer_sizes.find(names[i]);
+            if (it != buffer_sizes.end()) {
+                stats.buffer_bytes -= it->second;
+                stats.buffers--;
+                buffer_sizes.erase(it);
+            }
+        }
+    }
+
+    auto Map(GLenum target, GLsizeiptr length, GLbitfield access) -> void * {
+        auto &memory = mapped[target];
+        memory.resize(static_cast<size_t>(length));
+        if ((access & GL_MAP_READ_BIT) != 0) {
+            std::memset(memory.data(), 0, memory.size());
+        } else {
+            stats.uploaded_bytes += static_cast<uint64_t>(length);
+        }
+        return memory.data();
+    }
+};
+
+// NOLINTBEGIN(bugprone-easily-swappable-parameters)
+inline void NullGL::Load() {
+    // names
+    glad_glGenBuffers = [](GLsizei n, GLuint *names) {
+        Gen(n, names);
+        auto &gl = GetInstance();
+        for (GLsizei i = 0; i < n; i++) {
+            gl.buffer_sizes[names[i]] = 0;
+        }
+        gl.stats.buffers += static_cast<uint64_t>(n);
+    };
+    glad_glGenVertexArrays = &Gen;
+    glad_glGenTextures = &Gen;
+    glad_glGenRenderbuffers = &Gen;
+    glad_glGenFramebuffers = &Gen;
+    glad_glGenQueries = &Gen;
+    glad_glDeleteBuffers = [](GLsizei n, const GLuint *names) {
+        Call().DeleteBuffers(n, names);
+    };
+    glad_glDeleteVertexArrays = &Delete;
+    glad_glDeleteTextures = &Delete;
+    glad_glDeleteRenderbuffers = &Delete;
+    glad_glDeleteFramebuffers = &Delete;
+    glad_glDeleteQueries = &Delete;
+    glad_glCreateShader = [](GLenum /*type*/) -> GLuint {
+        return Call().next_name++;
+    };
+    glad_glCreateProgram = []() -> GLuint { return Call().next_name++; };
+    glad_glDeleteShader = [](GLuint /*shader*/) { Call(); };
+    glad_glDeleteProgram = [](GLuint /*program*/) { Call(); };
+
+    // buffers
+    glad_glBindBuffer = [](GLenum target, GLuint buffer) {
+        Call().bound[target] = buffer;
+    };
+    glad_glBufferData = [](GLenum target, GLsizeiptr size, const void *data,
+                           GLenum /*usage*/) {
+        auto &gl = Call();
+        gl.Allocate(target, size);
+        if (data != nullptr) {
+            gl.stats.uploaded_bytes += static_cast<uint64_t>(size);
+        }
+    };
+    glad_glBufferSubData = [](GLenum /*target*/, GLintptr /*offset*/,
+                              GLsizeiptr size, const void * /*data*/) {
+        Call().stats.uploaded_bytes += static_cast<uint64_t>(size);
+    };
+    glad_glMapBufferRange = [](GLenum target, GLintptr /*offset*/,
+                               GLsizeiptr length,
+                               GLbitfield access) -> void * {
+        return Call().Map(target, length, access);
+    };
+    glad_glUnmapBuffer = [](GLenum /*target*/) -> GLboolean {
+        Call();
+        return GL_TRUE;
+    };
+    glad_glCopyBufferSubData = [](GLenum /*read*/, GLenum /*write*/,
+                                  GLintptr /*read_offset*/,
+                                  GLintptr /*write_offset*/,
+                                  GLsizeiptr /*size*/) { Call(); };
+
+    // vertex arrays
+    glad_glBindVertexArray = [](GLuint /*array*/) { Call(); };
+    glad_glEnableVertexAttribArray = [](GLuint /*index*/) { Call(); };
+    glad_glVertexAttribPointer = [](GLuint /*index*/, GLint /*size*/,
+                                    GLenum /*type*/, GLboolean /*normalized*/,
+                                    GLsizei /*stride*/,
+                                    const void * /*pointer*/) { Call(); };
+    glad_glVertexAttribIPointer = [](GLuint /*index*/, GLint /*size*/,
+                                     GLenum /*type*/, GLsizei /*stride*/,
+                                     const void * /*pointer*/) { Call(); };
+    glad_glVertexAttribDivisor = [](GLuint /*index*/, GLuint /*divisor*/) {
+        Call();
+    };
+
+    // draws
+    glad_glDrawArrays = [](GLenum /*mode*/, GLint /*first*/, GLsizei count) {
+        Call().Draw(count, 1);
+    };
+    glad_glDrawArraysInstanced = [](GLenum /*mode*/, GLint /*first*/,
+                                    GLsizei count, GLsizei instances) {
+        Call().Draw(count, instances);
+    };
+    glad_glDrawElementsInstanced = [](GLenum /*mode*/, GLsizei count,
+                                      GLenum /*type*/,
+                                      const void * /*indices*/,
+                                      GLsizei instances) {
+        Call().Draw(count, instances);
+    };
+    glad_glDrawElementsInstancedBaseVertex =
+        [](GLenum /*mode*/, GLsizei count, GLenum /*type*/,
+           const void * /*indices*/, GLsizei instances,
+           GLint /*base_vertex*/) { Call().Draw(count, instances); };
+
+    // shaders and uniforms, compilation always succeeds
+    glad_glShaderSource = [](GLuint /*shader*/, GLsizei /*count*/,
+                             const GLchar *const * /*string*/,
+                             const GLint * /*length*/) { Call(); };
+    glad_glCompileShader = [](GLuint /*shader*/) { Call(); };
+    glad_glGetShaderiv = [](GLuint /*shader*/, GLenum pname, GLint *params) {
+        Call();
+        *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+    };
+    glad_glGetShaderInfoLog = [](GLuint /*shader*/, GLsizei buf_size,
+                                 GLsizei *length, GLchar *info_log) {
+        Call();
+        if (length != nullptr) {
+            *length = 0;
+        }
+        if (buf_size > 0) {
+            info_log[0] = '\0';
+        }
+    };
+    glad_glAttachShader = [](GLuint /*program*/, GLuint /*shader*/) {
+        Call();
+    };
+    glad_glLinkProgram = [](GLuint /*program*/) { Call(); };
+    glad_glUseProgram = [](GLuint /*program*/) { Call(); };
+    glad_glGetUniformLocation = [](GLuint /*program*/,
+                                   const GLchar * /*name*/) -> GLint {
+        Call();
+        return 0;
+    };
+    glad_glUniform1i = [](GLint /*location*/, GLint /*v0*/) { Call(); };
+    glad_glUniform2fv = [](GLint /*location*/, GLsizei /*count*/,
+                           const GLfloat * /*value*/) { Call(); };
+    glad_glUniformMatrix4fv = [](GLint /*location*/, GLsizei /*count*/,
+                                 GLboolean /*transpose*/,
+                                 const GLfloat * /*value*/) { Call(); };
+
+    // textures and framebuffers
+    glad_glActiveTexture = [](GLenum /*texture*/) { Call(); };
+    glad_glBindTexture = [](GLenum /*target*/, GLuint /*texture*/) {
+        Call();
+    };
+    glad_glTexParameteri = [](GLenum /*target*/, GLenum /*pname*/,
+                              GLint /*param*/) { Call(); };
+    glad_glTexImage2D = [](GLenum /*target*/, GLint /*level*/,
+                           GLint /*internal_format*/, GLsizei /*width*/,
+                           GLsizei /*height*/, GLint /*border*/,
+                           GLenum /*format*/, GLenum /*type*/,
+                           const void * /*pixels*/) { Call(); };
+    glad_glBindRenderbuffer = [](GLenum /*target*/, GLuint /*buffer*/) {
+        Call();
+    };
+    glad_glRenderbufferStorageMultisample =
+        [](GLenum /*target*/, GLsizei /*samples*/, GLenum /*format*/,
+           GLsizei /*width*/, GLsizei /*height*/) { Call(); };
+    glad_glBindFramebuffer = [](GLenum /*target*/, GLuint /*buffer*/) {
+        Call();
+    };
+    glad_glFramebufferTexture2D = [](GLenum /*target*/, GLenum /*attachment*/,
+                                     GLenum /*textarget*/, GLuint /*texture*/,
+                                     GLint /*level*/) { Call(); };
+    glad_glFramebufferRenderbuffer =
+        [](GLenum /*target*/, GLenum /*attachment*/,
+           GLenum /*renderbuffertarget*/, GLuint /*buffer*/) { Call(); };
+    glad_glCheckFramebufferStatus = [](GLenum /*target*/) -> GLenum {
+        Call();
+        return GL_FRAMEBUFFER_COMPLETE;
+    };
+    glad_glDrawBuffers = [](GLsizei /*n*/, const GLenum * /*bufs*/) {
+        Call();
+    };
+    glad_glBlitFramebuffer = [](GLint /*src_x0*/, GLint /*src_y0*/,
+                                GLint /*src_x1*/, GLint /*src_y1*/,
+                                GLint /*dst_x0*/, GLint /*dst_y0*/,
+                                GLint /*dst_x1*/, GLint /*dst_y1*/,
+                                GLbitfield /*mask*/, GLenum /*filter*/) {
+        Call();
+    };
+    glad_glPixelStorei = [](GLenum /*pname*/, GLint /*param*/) { Call(); };
+    // reads into client memory are zeros, pack buffers are left alone
+    glad_glReadPixels = [](GLint /*x*/, GLint /*y*/, GLsizei width,
+                           GLsizei height, GLenum /*format*/, GLenum /*type*/,
+                           void *pixels) {
+        auto &gl = Call();
+        if (gl.bound[GL_PIXEL_PACK_BUFFER] == 0 && pixels != nullptr) {
+            std::memset(pixels, 0,
+                        static_cast<size_t>(width) *
+                            static_cast<size_t>(height) * 4);
+        }
+    };
+
+    // state
+    glad_glEnable = [](GLenum /*cap*/) { Call(); };
+    glad_glDisable = [](GLenum /*cap*/) { Call(); };
+    glad_glViewport = [](GLint /*x*/, GLint /*y*/, GLsizei /*width*/,
+                         GLsizei /*height*/) { Call(); };
+    glad_glClear = [](GLbitfield /*mask*/) { Call(); };
+    glad_glClearColor = [](GLfloat /*red*/, GLfloat /*green*/,
+                           GLfloat /*blue*/, GLfloat /*alpha*/) { Call(); };
+    glad_glClearBufferfv = [](GLenum /*buffer*/, GLint /*drawbuffer*/,
+                              const GLfloat * /*value*/) { Call(); };
+    glad_glBlendFunc = [](GLenum /*sfactor*/, GLenum /*dfactor*/) {
+        Call();
+    };
+    glad_glBlendFuncSeparate = [](GLenum /*src_rgb*/, GLenum /*dst_rgb*/,
+                                  GLenum /*src_alpha*/,
+                                  GLenum /*dst_alpha*/) { Call(); };
+    glad_glDepthFunc = [](GLenum /*func*/) { Call(); };
+    glad_glDepthMask = [](GLboolean /*flag*/) { Call(); };
+    glad_glColorMask = [](GLboolean /*red*/, GLboolean /*green*/,
+                          GLboolean /*blue*/, GLboolean /*alpha*/) { Call(); };
+
+    // queries and synchronization, results are always available
+    glad_glGetError = []() -> GLenum {
+        Call();
+        return GL_NO_ERROR;
+    };
+    glad_glGetIntegerv = [](GLenum pname, GLint *data) {
+        Call();
+        switch (pname) {
+            case GL_MAJOR_VERSION:
+                *data = 3;
+                break;
+            case GL_MINOR_VERSION:
+                *data = 3;
+                break;
+            default:
+                *data = 0;
+                break;
+        }
+    };
+    glad_glGetString = [](GLenum name) -> const GLubyte * {
+        Call();
+        const char *value = name == GL_VERSION ? "3.3 glviskit null"
+                                               : "glviskit null";
+        return reinterpret_cast<const GLubyte *>(value);
+    };
+    glad_glGetStringi = [](GLenum /*name*/,
+                           GLuint /*index*/) -> const GLubyte * {
+        Call();
+        return nullptr;
+    };
+    glad_glBeginQuery = [](GLenum /*target*/, GLuint /*id*/) { Call(); };
+    glad_glEndQuery = [](GLenum /*target*/) { Call(); };
+    glad_glGetQueryObjectiv = [](GLuint /*id*/, GLenum /*pname*/,
+                                 GLint *params) {
+        Call();
+        *params = 1;
+    };
+    glad_glGetQueryObjectui64v = [](GLuint /*id*/, GLenum /*pname*/,
+                                    GLuint64 *params) {
+        Call();
+        *params = 0;
+    };
+    glad_glFenceSync = [](GLenum /*condition*/,
+                          GLbitfield /*flags*/) -> GLsync {
+        Call();
+        static int fence = 0;
+        return reinterpret_cast<GLsync>(&fence);
+    };
+    glad_glClientWaitSync = [](GLsync /*sync*/, GLbitfield /*flags*/,
+                               GLuint64 /*timeout*/) -> GLenum {
+        Call();
+        return GL_ALREADY_SIGNALED;
+    };
+    glad_glDeleteSync = [](GLsync /*sync*/) { Call(); };
+    glad_glFlush = []() { Call(); };
+    glad_glFinish = []() { Call(); };
+}
+// NOLINTEND(bugprone-easily-swappable-parameters)
+
+}  // namespace glviskit
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+
+#include "../gl/counters.hpp"
+#include "../gl/framebuffer.hpp"
+#include "../gl/gl.hpp"
+#include "../gl/program.hpp"
+#include "../gl/vao.hpp"
+
+namespace glviskit::oit {
+
+// Weighted blended order-independent transparency (McGuire & Bavoil 2013).
+// Translucent primitives are drawn unsorted into two float targets:
+//   attachment 0: rgb = sum(color * alpha * weight), a = prod(1 - alpha)
+//   attachment 1: r = sum(alpha * weight)
+// GL 3.3 and GLES 3 have no per-attachment blend functions, so the
+// revealage product is kept in the alpha channel of the accumulation target
+// and a single glBlendFuncSeparate serves both attachments.
+
+// Shared fragment output code for OIT variants of primitive shaders.
+// Call oit_output(color) instead of writing a single color output.
+#define GLVISKIT_OIT_FRAG_OUTPUT                                      \
+    "layout(location = 0) out vec4 f_accum;\n"                        \
+    "layout(location = 1) out vec4 f_weight;\n"                       \
+    "void oit_output(vec4 color) {\n"                                 \
+    "    highp float a = color.a;\n"                                  \
+    "    highp float z = 1.0 - gl_FragCoord.z * 0.9;\n"               \
+    "    highp float w = clamp(pow(min(1.0, a * 10.0) + 0.01, 3.0) *" \
+    "        1e8 * z * z * z, 1e-2, 3e3);\n"                          \
+    "    f_accum = vec4(color.rgb * a * w, a);\n"                     \
+    "    f_weight = vec4(a * w);\n"                                   \
+    "}\n"
+
+// fullscreen triangle resolving the accumulated targets
+// NOLINTNEXTLINE(hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+inline constexpr char shader_vertex[] = GLVISKIT_VERT_HEADER R"glsl(
+    void main() {
+        vec2 p = vec2(float((gl_VertexID & 1) << 2),
+                      float((gl_VertexID & 2) << 1)) - 1.0;
+        gl_Position = vec4(p, 0.0, 1.0);
+    }
+)glsl";
+
+// NOLINTNEXTLINE(hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+inline constexpr char shader_fragment[] = GLVISKIT_FRAG_HEADER R"glsl(
+    uniform highp sampler2D u_accum;
+    uniform highp sampler2D u_weight;
+    out vec4 f_color;
+
+    void main() {
+        ivec2 coord = ivec2(gl_FragCoord.xy);
+        highp vec4 accum = texelFetch(u_accum, coord, 0);
+        highp float revealage = accum.a;
+        if (revealage >= 1.0) {
+            discard;
+        }
+        highp float weight = texelFetch(u_weight, coord, 0).r;
+        f_color = vec4(accum.rgb / max(weight, 1e-5), 1.0 - revealage);
+    }
+)glsl";
+
+// NOLINTNEXTLINE(hicpp-no-array-decay)
+using Program = Program<shader_vertex, shader_fragment, false>;
+
+// Owns the accumulation targets of a single context and drives the pass.
+// Usage per frame: Begin, depth-only draw of opaque geometry, Accumulate,
+// draw translucent geometry with OIT programs, Composite.
+class Pass {
+   public:
+    Pass() {
+        program.Use();
+        glUniform1i(glGetUniformLocation(program.Get(), "u_accum"), 0);
+        glUniform1i(glGetUniformLocation(program.Get(), "u_weight"), 1);
+        GLState::UseProgram(0);
+    }
+
+    // bind and clear the targets, returns false if float render targets
+    // are unavailable in which case the caller should render normally
+    auto Begin(int width, int height) -> bool {
+        if (!supported) {
+            return false;
+        }
+
+        // composite back into whatever framebuffer was bound
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+
+        framebuffer.Bind();
+        if (width != width_ || height != height_) {
+            if (!Allocate(width, height)) {
+                std::cerr << "Warning: weighted blended transparency is not "
+                             "supported, falling back to alpha to coverage"
+                          << '\n';
+                supported = false;
+                glBindFramebuffer(GL_FRAMEBUFFER, target);
+                return false;
+            }
+        }
+
+        static constexpr std::array<GLfloat, 4> accum_clear{0.0F, 0.0F, 0.0F,
+                                                            1.0F};
+        static constexpr std::array<GLfloat, 4> weight_clear{0.0F, 0.0F, 0.0F,
+                                                             0.0F};
+        static constexpr GLfloat depth_clear = 1.0F;
+        glClearBufferfv(GL_COLOR, 0, accum_clear.data());
+        glClearBufferfv(GL_COLOR, 1, weight_clear.data());
+        glClearBufferfv(GL_DEPTH, 0, &depth_clear);
+
+        // depth only until Accumulate
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        return true;
+    }
+
+    // switch to accumulating translucent fragments,
+    // depth of opaque geometry drawn since Begin is kept for testing
+    static void Accumulate() {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_FALSE);
+        glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // blend the resolved translucent layer over the target framebuffer
+    // and restore the default renderer state
+    void Composite() {
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glDisable(GL_DEPTH_TEST);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        program.Use();
+        glActiveTexture(GL_TEXTURE0);
+        accum.Bind();
+        glActiveTexture(GL_TEXTURE1);
+        weight.Bind();
+
+        vao.Bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        GLVISKIT_COUNT_GL(draw_calls, 1);
+        vao.Unbind();
+
+        weight.Unbind();
+        glActiveTexture(GL_TEXTURE0);
+        accum.Unbind();
+
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    }
+
+    // bytes of the accumulation targets
+    [[nodiscard]] auto MemoryBytes() const -> size_t {
+        // RGBA16F accumulation, R16F weight and 24 bit depth
+        constexpr size_t kBytesPerPixel = 8 + 2 + 4;
+        return static_cast<size_t>(width_) * static_cast<size_t>(height_) *
+               kBytesPerPixel;
+    }
+
+   private:
+    Program program;
+    Framebuffer framebuffer;
+    Texture accum;
+    Texture weight;
+    Renderbuffer depth;
+    // attribute-less draws still need a bound VAO in core profile
+    VAO vao;
+
+    GLint target{0};
+    int width_{0};
+    int height_{0};
+    bool supported{true};
+
+    // expects the framebuffer to be bound
+    auto Allocate(int width, int height) -> bool {
+        accum.Allocate(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, width, height);
+        weight.Allocate(GL_R16F, GL_RED, GL_HALF_FLOAT, width, height);
+        depth.Allocate(GL_DEPTH_COMPONENT24, width, height);
+
+        framebuffer.Attach(GL_COLOR_ATTACHMENT0, accum);
+        framebuffer.Attach(GL_COLOR_ATTACHMENT1, weight);
+        framebuffer.Attach(GL_DEPTH_ATTACHMENT, depth);
+
+        static constexpr std::array<GLenum, 2> draw_buffers{
+            GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, draw_buffers.data());
+
+        width_ = width;
+        height_ = height;
+        return framebuffer.Complete();
+    }
+};
+
+}  // namespace glviskit::oit
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../gl/counters.hpp"
+#include "../gl/gl.hpp"
+
+namespace glviskit {
+
+// A frame read back from the GPU, RGBA rows with the top row first
+struct PixelFrame {
+    int width{0};
+    int height{0};
+    // index of the rendered frame the pixels belong to
+    uint64_t frame{0};
+    std::vector<uint8_t> pixels;
+};
+
+// Ring of pixel pack buffers for reading frames back without stalling.
+// Queue starts an asynchronous glReadPixels into the next buffer followed by
+// a fence, Poll returns the newest frame whose fence has already signaled.
+// With the default ring of three that is usually the frame rendered one or
+// two frames earlier. Frames that are never polled are overwritten.
+class PixelReader {
+   public:
+    explicit PixelReader(size_t ring_size = 3) : slots(ring_size) {}
+
+    ~PixelReader() {
+        for (auto &slot : slots) {
+            Release(slot);
+            glDeleteBuffers(1, &slot.buffer);
+        }
+    }
+
+    // this class is non-copyable and non-movable
+    PixelReader(const PixelReader &) = delete;
+    auto operator=(const PixelReader &) -> PixelReader & = delete;
+    PixelReader(PixelReader &&) = delete;
+    auto operator=(PixelReader &&) -> PixelReader & = delete;
+
+    // read the bound read framebuffer into the next slot
+    void Queue(int width, int height, uint64_t frame) {
+        auto &slot = slots[next];
+        Release(slot);
+
+        slot.width = width;
+        slot.height = height;
+        slot.frame = frame;
+        auto bytes = static_cast<size_t>(width) * height * 4;
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+#if defined(__EMSCRIPTEN__)
+        // WebGL cannot map buffers, read synchronously instead
+        slot.data.resize(bytes);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                     slot.data.data());
+        slot.pending = true;
+#else
+        if (slot.buffer == 0) {
+            glGenBuffers(1, &slot.buffer);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        GLVISKIT_COUNT_GL(buffer_binds, 1);
+        if (slot.capacity != bytes) {
+            glBufferData(GL_PIXEL_PACK_BUFFER,
+                         static_cast<GLsizeiptr>(bytes), nullptr,
+                         GL_STREAM_READ);
+            slot.capacity = bytes;
+        }
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.pending = true;
+#endif
+
+        next = (next + 1) % slots.size();
+    }
+
+    // newest completed frame, or nullptr if nothing completed since the
+    // last call, never waits for the GPU
+    auto Poll() -> std::shared_ptr<PixelFrame> {
+        // fences signal in order, walk from the oldest slot and stop at the
+        // first one still in flight
+        Slot *newest = nullptr;
+        for (size_t i = 0; i < slots.size(); i++) {
+            auto &slot = slots[(next + i) % slots.size()];
+            if (!slot.pending) {
+                continue;
+            }
+            if (!Signaled(slot)) {
+                break;
+            }
+            if (newest != nullptr) {
+                Release(*newest);
+            }
+            newest = &slot;
+        }
+
+        if (newest == nullptr) {
+            return nullptr;
+        }
+
+        auto frame = Read(*newest);
+        Release(*newest);
+        return frame;
+    }
+
+    // bytes of the pack buffers and client side copies
+    [[nodiscard]] auto MemoryBytes() const -> size_t {
+        size_t bytes = 0;
+        for (const auto &slot : slots) {
+            bytes += slot.capacity + slot.data.capacity();
+        }
+        return bytes;
+    }
+
+   private:
+    struct Slot {
+        GLuint buffer{0};
+        GLsync fence{nullptr};
+        size_t capacity{0};
+        bool pending{false};
+        int width{0};
+        int height{0};
+        uint64_t frame{0};
+        // client side copy where buffers cannot be mapped
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<Slot> slots;
+    size_t next{0};
+
+    static auto Signaled(Slot &slot) -> bool {
+#if defined(__EMSCRIPTEN__)
+        (void)slot;
+        return true;
+#else
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        return status == GL_ALREADY_SIGNALED ||
+               status == GL_CONDITION_SATISFIED;
+#endif
+    }
+
+    static void Release(Slot &slot) {
+        if (slot.fence != nullptr) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        slot.pending = false;
+    }
+
+    static auto Read(Slot &slot) -> std::shared_ptr<PixelFrame> {
+        auto frame = std::make_shared<PixelFrame>();
+        frame->width = slot.width;
+        frame->height = slot.height;
+        frame->frame = slot.frame;
+
+        const auto row = static_cast<size_t>(slot.width) * 4;
+        const auto rows = static_cast<size_t>(slot.height);
+        frame->pixels.resize(row * rows);
+
+#if defined(__EMSCRIPTEN__)
+        const auto *src = slot.data.data();
+#else
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        GLVISKIT_COUNT_GL(buffer_binds, 1);
+        const auto *src = static_cast<const uint8_t *>(
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                             static_cast<GLsizeiptr>(row * rows),
+                             GL_MAP_READ_BIT));
+#endif
+
+        // GL rows start at the bottom, flip while copying out
+        if (src != nullptr) {
+            for (size_t y = 0; y < rows; y++) {
+                std::copy_n(src + ((rows - 1 - y) * row), row,
+                            frame->pixels.data() + (y * row));
+            }
+        }
+
+#if !defined(__EMSCRIPTEN__)
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+        return frame;
+    }
+};
+
+}  // namespace glviskit
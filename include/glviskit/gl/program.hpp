@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include "../gl/gl.hpp"
+#include "../gl/state.hpp"
 
 namespace glviskit {
 
@@ -18,7 +19,10 @@ namespace glviskit {
     #error "No GL version defined"
 #endif
 
-template <const char *shader_vertex, const char *shader_fragment>
+// camera_uniforms is false for screen space programs that have no
+// mvp or screen_size uniforms, which silences the missing uniform warnings
+template <const char *shader_vertex, const char *shader_fragment,
+          bool camera_uniforms = true>
 class Program {
    public:
     Program() {
@@ -66,12 +70,12 @@ class Program {
         glDeleteShader(s_frag);
 
         loc_mvp = glGetUniformLocation(program, "mvp");
-        if (loc_mvp == -1) {
+        if (camera_uniforms && loc_mvp == -1) {
             std::cerr << "Warning: mvp uniform not found in shader program"
                       << '\n';
         }
         loc_screen_size = glGetUniformLocation(program, "screen_size");
-        if (loc_screen_size == -1) {
+        if (camera_uniforms && loc_screen_size == -1) {
             std::cerr
                 << "Warning: screen_size uniform not found in shader program"
                 << '\n';
@@ -81,6 +85,7 @@ class Program {
     // destructor
     ~Program() {
         if (program != 0) {
+            GLState::ForgetProgram(program);
             glDeleteProgram(program);
             program = 0;
             loc_mvp = 0;
@@ -105,6 +110,7 @@ class Program {
     auto operator=(Program &&other) noexcept -> Program & {
         if (this != &other) {
             if (program != 0) {
+                GLState::ForgetProgram(program);
                 glDeleteProgram(program);
             }
             program = other.program;
@@ -117,7 +123,8 @@ class Program {
         return *this;
     }
 
-    void Use() { glUseProgram(program); }
+    [[nodiscard]] auto Get() const -> GLuint { return program; }
+    void Use() const { GLState::UseProgram(program); }
 
     void SetMVP(const glm::mat4 &mvp) {
         if (loc_mvp == -1) {
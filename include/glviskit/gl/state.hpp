@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "../gl/counters.hpp"
+#include "../gl/gl.hpp"
+
+// the binding cache is on unless GLVISKIT_GL_STATE_CACHE is defined to 0
+#if !defined(GLVISKIT_GL_STATE_CACHE)
+#define GLVISKIT_GL_STATE_CACHE 1
+#endif
+
+namespace glviskit {
+
+// Cache of the vertex array, array and element buffer and program bindings
+// of one GL context. Windows own one per context and make it current along
+// with the context, binds through it skip calls that would not change
+// anything. Unbinding is lazy, the object stays bound until something else
+// is bound, except that a released vertex array is unbound before an element
+// buffer is bound so that uploads never modify it.
+// Deleted objects are forgotten in the caches of all contexts, their names
+// may be reused while another context still has the old object bound.
+// Without a current cache every call goes straight to GL.
+// Only meant to be used from the thread that issues GL calls.
+class GLState {
+   public:
+    static constexpr bool kEnabled = GLVISKIT_GL_STATE_CACHE != 0;
+
+    GLState() { Registry().push_back(this); }
+
+    ~GLState() {
+        auto &registry = Registry();
+        registry.erase(std::remove(registry.begin(), registry.end(), this),
+                       registry.end());
+        if (current == this) {
+            current = nullptr;
+        }
+    }
+
+    // this class is non-copyable and non-movable
+    GLState(const GLState &) = delete;
+    auto operator=(const GLState &) -> GLState & = delete;
+    GLState(GLState &&) = delete;
+    auto operator=(GLState &&) -> GLState & = delete;
+
+    // call whenever this cache's context is made current
+    void MakeCurrent() { current = this; }
+
+    // forget everything, for when GL state was changed behind our back
+    void Invalidate() {
+        vao = kUnknown;
+        vao_bound = false;
+        array_buffer = kUnknown;
+        element_buffer = kUnknown;
+        program = kUnknown;
+    }
+
+    static void BindVertexArray(GLuint name) {
+        auto *state = Cache();
+        if (state == nullptr) {
+            glBindVertexArray(name);
+            return;
+        }
+        state->vao_bound = name != 0;
+        if (state->vao == name) {
+            GLVISKIT_COUNT_GL(elided_calls, 1);
+            return;
+        }
+        glBindVertexArray(name);
+        state->vao = name;
+        // the element buffer binding belongs to the vertex array
+        state->element_buffer = kUnknown;
+    }
+
+    static void ReleaseVertexArray() {
+        auto *state = Cache();
+        if (state == nullptr) {
+            glBindVertexArray(0);
+            return;
+        }
+        state->vao_bound = false;
+        GLVISKIT_COUNT_GL(elided_calls, 1);
+    }
+
+    static void BindBuffer(GLenum target, GLuint name) {
+        auto *state = Cache();
+        GLuint *cached = state != nullptr ? state->Binding(target) : nullptr;
+        if (cached == nullptr) {
+            glBindBuffer(target, name);
+            GLVISKIT_COUNT_GL(buffer_binds, 1);
+            return;
+        }
+        if (target == GL_ELEMENT_ARRAY_BUFFER && !state->vao_bound &&
+            state->vao != 0) {
+            BindVertexArray(0);
+        }
+        if (*cached == name) {
+            GLVISKIT_COUNT_GL(elided_calls, 1);
+            return;
+        }
+        glBindBuffer(target, name);
+        GLVISKIT_COUNT_GL(buffer_binds, 1);
+        *cached = name;
+    }
+
+    static void ReleaseBuffer(GLenum target) {
+        auto *state = Cache();
+        if (state == nullptr || state->Binding(target) == nullptr) {
+            glBindBuffer(target, 0);
+            return;
+        }
+        GLVISKIT_COUNT_GL(elided_calls, 1);
+    }
+
+    static void UseProgram(GLuint name) {
+        auto *state = Cache();
+        if (state != nullptr && state->program == name) {
+            GLVISKIT_COUNT_GL(elided_calls, 1);
+            return;
+        }
+        glUseProgram(name);
+        GLVISKIT_COUNT_GL(program_switches, 1);
+        if (state != nullptr) {
+            state->program = name;
+        }
+    }
+
+    // call before deleting an object
+    static void ForgetVertexArray(GLuint name) {
+        for (auto *state : Registry()) {
+            if (state->vao == name) {
+                state->vao = kUnknown;
+                state->vao_bound = false;
+            }
+        }
+    }
+
+    static void ForgetBuffer(GLuint name) {
+        for (auto *state : Registry()) {
+            Forget(state->array_buffer, name);
+            Forget(state->element_buffer, name);
+        }
+    }
+
+    static void ForgetProgram(GLuint name) {
+        for (auto *state : Registry()) {
+            Forget(state->program, name);
+        }
+    }
+
+   private:
+    // never a valid name, forces the next bind
+    static constexpr GLuint kUnknown = ~GLuint{0};
+
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+    static inline thread_local GLState *current = nullptr;
+
+    GLuint vao{kUnknown};
+    // whether vao was bound and not yet released
+    bool vao_bound{false};
+    GLuint array_buffer{kUnknown};
+    GLuint element_buffer{kUnknown};
+    GLuint program{kUnknown};
+
+    static auto Cache() -> GLState * { return kEnabled ? current : nullptr; }
+
+    // never destroyed, windows owning caches may be destroyed later by
+    // singleton destructors
+    static auto Registry() -> std::vector<GLState *> & {
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        static auto *registry = new std::vector<GLState *>();
+        return *registry;
+    }
+
+    static void Forget(GLuint &cached, GLuint name) {
+        if (cached == name) {
+            cached = kUnknown;
+        }
+    }
+
+    // other targets are not cached
+    auto Binding(GLenum target) -> GLuint * {
+        switch (target) {
+            case GL_ARRAY_BUFFER:
+                return &array_buffer;
+            case GL_ELEMENT_ARRAY_BUFFER:
+                return &element_buffer;
+            default:
+                return nullptr;
+        }
+    }
+};
+
+}  // namespace glviskit
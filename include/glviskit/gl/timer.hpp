@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../gl/gl.hpp"
+#include "../stats.hpp"
+#include "../trace.hpp"
+
+namespace glviskit {
+
+// Measures GPU time of render passes with GL_TIME_ELAPSED queries.
+// Queries of a frame are read back kFrames frames later, if they are still
+// not available by then the frame is dropped instead of waiting.
+// Elapsed time queries cannot nest, so with per buffer timing every buffer
+// of a pass gets its own query and the pass time is their sum.
+// GLES 3 has no timer queries, there all calls are no-ops.
+class GPUTimer {
+   public:
+    enum class Pass : uint8_t { Lines, Points, Circles, Composite, Count };
+
+    // timed region without a buffer
+    static constexpr size_t kNoBuffer = static_cast<size_t>(-1);
+
+    static auto PassName(Pass pass) -> const char * {
+        switch (pass) {
+            case Pass::Lines:
+                return "lines";
+            case Pass::Points:
+                return "points";
+            case Pass::Circles:
+                return "circles";
+            case Pass::Composite:
+                return "composite";
+            default:
+                return "unknown";
+        }
+    }
+
+    GPUTimer() = default;
+
+    ~GPUTimer() {
+#if defined(GLVISKIT_GL33)
+        for (auto &frame : frames) {
+            for (auto &entry : frame.entries) {
+                glDeleteQueries(1, &entry.query);
+            }
+        }
+#endif
+    }
+
+    // this class is non-copyable and non-movable
+    GPUTimer(const GPUTimer &) = delete;
+    auto operator=(const GPUTimer &) -> GPUTimer & = delete;
+    GPUTimer(GPUTimer &&) = delete;
+    auto operator=(GPUTimer &&) -> GPUTimer & = delete;
+
+    void SetEnabled(bool enabled, bool per_buffer) {
+#if defined(GLVISKIT_GL33)
+        this->enabled = enabled;
+        this->per_buffer = per_buffer;
+#else
+        (void)enabled;
+        (void)per_buffer;
+#endif
+    }
+
+    [[nodiscard]] auto Enabled() const -> bool { return enabled; }
+    [[nodiscard]] auto PerBuffer() const -> bool { return per_buffer; }
+
+    [[nodiscard]] auto Stats() const -> const FrameStats & { return stats; }
+
+    // collect the oldest frame and start recording into its slot
+    void BeginFrame() {
+        if (!enabled) {
+            return;
+        }
+        auto &frame = frames[current];
+        Collect(frame);
+        frame.used = 0;
+    }
+
+    void EndFrame() {
+        if (!enabled) {
+            return;
+        }
+        current = (current + 1) % kFrames;
+    }
+
+    void Begin(Pass pass, size_t buffer = kNoBuffer) {
+#if defined(GLVISKIT_GL33)
+        if (!enabled) {
+            return;
+        }
+        auto &frame = frames[current];
+        if (frame.used == frame.entries.size()) {
+            Entry entry{};
+            glGenQueries(1, &entry.query);
+            frame.entries.push_back(entry);
+        }
+        auto &entry = frame.entries[frame.used++];
+        entry.pass = pass;
+        entry.buffer = buffer;
+        // submission time places the result on the trace timeline
+        auto &tracer = Tracer::GetInstance();
+        entry.submit_ns = tracer.Enabled() ? tracer.Now() : -1;
+        glBeginQuery(GL_TIME_ELAPSED, entry.query);
+#else
+        (void)pass;
+        (void)buffer;
+#endif
+    }
+
+    void End() const {
+#if defined(GLVISKIT_GL33)
+        if (!enabled) {
+            return;
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+#endif
+    }
+
+   private:
+    static constexpr size_t kFrames = 4;
+
+    struct Entry {
+        GLuint query;
+        Pass pass;
+        size_t buffer;
+        int64_t submit_ns;
+    };
+
+    struct Frame {
+        // queries are reused across frames, used counts this frame's
+        std::vector<Entry> entries;
+        size_t used{0};
+    };
+
+    std::array<Frame, kFrames> frames{};
+    size_t current{0};
+    bool enabled{false};
+    bool per_buffer{false};
+    FrameStats stats;
+
+    void Collect(Frame &frame) {
+#if defined(GLVISKIT_GL33)
+        if (frame.used == 0) {
+            return;
+        }
+
+        // queries complete in order, checking the last one is enough
+        GLint available = 0;
+        glGetQueryObjectiv(frame.entries[frame.used - 1].query,
+                           GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0) {
+            return;
+        }
+
+        std::array<double, static_cast<size_t>(Pass::Count)> passes{};
+        std::vector<double> buffers;
+        for (size_t i = 0; i < frame.used; i++) {
+            const auto &entry = frame.entries[i];
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(entry.query, GL_QUERY_RESULT, &elapsed);
+            double ms = static_cast<double>(elapsed) * 1e-6;
+            if (entry.submit_ns >= 0) {
+                Tracer::GetInstance().Record(
+                    PassName(entry.pass), "gpu", entry.submit_ns,
+                    static_cast<int64_t>(elapsed), true);
+            }
+
+            passes[static_cast<size_t>(entry.pass)] += ms;
+            if (entry.buffer != kNoBuffer) {
+                if (buffers.size() <= entry.buffer) {
+                    buffers.resize(entry.buffer + 1, 0.0);
+                }
+                buffers[entry.buffer] += ms;
+            }
+        }
+
+        stats.lines.Add(passes[static_cast<size_t>(Pass::Lines)]);
+        stats.points.Add(passes[static_cast<size_t>(Pass::Points)]);
+        stats.circles.Add(passes[static_cast<size_t>(Pass::Circles)]);
+        stats.composite.Add(passes[static_cast<size_t>(Pass::Composite)]);
+        double total = 0.0;
+        for (double ms : passes) {
+            total += ms;
+        }
+        stats.total.Add(total);
+
+        if (stats.buffers.size() < buffers.size()) {
+            stats.buffers.resize(buffers.size());
+        }
+        for (size_t b = 0; b < buffers.size(); b++) {
+            stats.buffers[b].Add(buffers[b]);
+        }
+        stats.frames++;
+#else
+        (void)frame;
+#endif
+    }
+};
+
+}  // namespace glviskit
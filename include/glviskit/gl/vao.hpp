@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../gl/gl.hpp"
+#include "../gl/state.hpp"
 
 namespace glviskit {
 
@@ -9,7 +10,7 @@ class VAO {
     VAO() { glGenVertexArrays(1, &vao); }
 
     // destructor
-    ~VAO() { glDeleteVertexArrays(1, &vao); }
+    ~VAO() { Delete(); }
 
     // this class is non-copyable
     VAO(const VAO &) = delete;
@@ -20,7 +21,7 @@ class VAO {
 
     auto operator=(VAO &&other) noexcept -> VAO & {
         if (this != &other) {
-            glDeleteVertexArrays(1, &vao);
+            Delete();
 
             vao = other.vao;
 
@@ -30,12 +31,19 @@ class VAO {
     }
 
     [[nodiscard]] auto Get() const -> GLuint { return vao; }
-    void Bind() const { glBindVertexArray(vao); }
+    void Bind() const { GLState::BindVertexArray(vao); }
     // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-    void Unbind() const { glBindVertexArray(0); }
+    void Unbind() const { GLState::ReleaseVertexArray(); }
 
    private:
     GLuint vao{};
+
+    void Delete() {
+        if (vao != 0) {
+            GLState::ForgetVertexArray(vao);
+            glDeleteVertexArrays(1, &vao);
+        }
+    }
 };
 
 }  // namespace glviskit
\ No newline at end of file
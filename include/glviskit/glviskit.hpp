@@ -2,19 +2,45 @@
 
 // NOLINTBEGIN(unused-includes)
 #include "camera.hpp"
+#include "convert.hpp"
+#include "gl/counters.hpp"
+#include "memory.hpp"
+#include "profiler.hpp"
+#include "recorder.hpp"
 #include "render_buffer.hpp"
+#include "render_thread.hpp"
 #include "renderer.hpp"
+#include "trace.hpp"
+#if defined(GLVISKIT_USE_GL_NONE)
+#include "null/manager.hpp"
+#include "null/window.hpp"
+#elif defined(GLVISKIT_HEADLESS)
+#include "offscreen/manager.hpp"
+#include "offscreen/window.hpp"
+#else
 #include "sdl/manager.hpp"
 #include "sdl/window.hpp"
+#endif
 // NOLINTEND(unused-includes)
 
 namespace glviskit {
 
+#if defined(GLVISKIT_USE_GL_NONE)
+// record GL calls without a driver
+using Manager = null::Manager;
+using Window = null::Window;
+#elif defined(GLVISKIT_HEADLESS)
+// render into framebuffer objects without a display
+using Manager = offscreen::Manager;
+using Window = offscreen::Window;
+#else
 // use SDL as the default window manager
 using Manager = sdl::Manager;
+using Window = sdl::Window;
+#endif
 
 static auto CreateWindow(const char *title, int w, int h)
-    -> std::shared_ptr<sdl::Window> {
+    -> std::shared_ptr<Window> {
     return Manager::GetInstance().CreateWindow(title, w, h);
 }
 
@@ -29,4 +55,59 @@ static auto GetTimeSeconds() -> float {
 static auto Loop() -> bool { return Manager::GetInstance().Loop(); }
 static void Render() { Manager::GetInstance().Render(); }
 
+// render on a thread of its own, fed by Record and Loop
+static void StartRenderThread() { Manager::GetInstance().StartRenderThread(); }
+static void StopRenderThread() { Manager::GetInstance().StopRenderThread(); }
+
+static auto Record(const std::shared_ptr<RenderBuffer> &buffer) -> Recorder & {
+    return Manager::GetInstance().Record(buffer);
+}
+
+static void SetRenderOnDemand(bool enabled) {
+    Manager::GetInstance().SetRenderOnDemand(enabled);
+}
+
+// the render thread writes the profiler, the GL call counts and the
+// buffers every frame, so they are only read while it is stopped
+static void EnsureNotThreaded(const char *what) {
+    ThrowIfThreaded(Manager::GetInstance().RenderThreadRunning(), what);
+}
+
+static void SetProfiling(bool enabled) {
+    EnsureNotThreaded("SetProfiling");
+    Profiler::GetInstance().SetEnabled(enabled);
+}
+
+static auto GetProfileReport() -> ProfileReport {
+    EnsureNotThreaded("GetProfileReport");
+    return Profiler::GetInstance().Report();
+}
+
+static auto GetMemoryUsage() -> MemoryReport {
+    return Manager::GetInstance().MemoryUsage();
+}
+
+static void SetTracing(bool enabled) {
+    Tracer::GetInstance().SetEnabled(enabled);
+}
+
+static auto DumpTrace(const std::string &path) -> bool {
+    return Tracer::GetInstance().DumpToFile(path);
+}
+
+// zero unless built with GLVISKIT_GL_COUNTERS, on by default without NDEBUG
+static auto GetGLCallCounts() -> GLCallCounts {
+    EnsureNotThreaded("GetGLCallCounts");
+    return GLCallCounter::GetInstance().LastFrame();
+}
+
+#if defined(GLVISKIT_USE_GL_NONE)
+// GL calls recorded by the null backend since the last reset
+static auto GetNullGLStats() -> NullGLStats {
+    return NullGL::GetInstance().Stats();
+}
+
+static void ResetNullGLStats() { NullGL::GetInstance().Reset(); }
+#endif
+
 }  // namespace glviskit
\ No newline at end of file
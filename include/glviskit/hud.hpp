@@ -0,0 +1,338 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <glm/glm.hpp>
+
+#include "gl/buffer_object.hpp"
+#include "gl/counters.hpp"
+#include "gl/gl.hpp"
+#include "gl/program.hpp"
+#include "gl/vao.hpp"
+
+namespace glviskit::hud {
+
+// Performance overlay in the top left corner of a window.
+// Text uses an embedded 5x7 bitmap font, every character is one instanced
+// quad that carries its glyph bits, so there are no textures and the fixed
+// size buffer is only rewritten when the text is refreshed, a few times per
+// second. Lowercase letters are drawn as uppercase, unknown characters as
+// spaces.
+
+// NOLINTNEXTLINE(hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+inline constexpr char shader_vertex[] = GLVISKIT_VERT_HEADER R"glsl(
+    layout(location = 0) in vec2 a_origin;
+    layout(location = 1) in vec2 a_size;
+    layout(location = 2) in highp uvec2 a_bits;
+    layout(location = 3) in vec4 a_color;
+
+    uniform vec2 screen_size;
+
+    out vec2 v_cell;
+    flat out highp uvec2 v_bits;
+    out vec4 v_color;
+
+    void main() {
+        // two triangles from the vertex id
+        int i = gl_VertexID;
+        vec2 corner = vec2(float(i == 1 || i == 4 || i == 5),
+                           float(i == 2 || i == 3 || i == 5));
+        // pixel coordinates from the top left corner
+        vec2 p = a_origin + corner * a_size;
+        gl_Position = vec4(p.x / screen_size.x * 2.0 - 1.0,
+                           1.0 - p.y / screen_size.y * 2.0, 0.0, 1.0);
+        v_cell = corner * vec2(5.0, 7.0);
+        v_bits = a_bits;
+        v_color = a_color;
+    }
+)glsl";
+
+// NOLINTNEXTLINE(hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+inline constexpr char shader_fragment[] = GLVISKIT_FRAG_HEADER R"glsl(
+    in vec2 v_cell;
+    flat in highp uvec2 v_bits;
+    in vec4 v_color;
+    out vec4 f_color;
+
+    void main() {
+        int col = min(int(v_cell.x), 4);
+        int row = min(int(v_cell.y), 6);
+        int bit = row * 5 + (4 - col);
+        highp uint word = bit < 32 ? v_bits.x : v_bits.y;
+        if (((word >> uint(bit & 31)) & 1u) == 0u) {
+            discard;
+        }
+        f_color = v_color;
+    }
+)glsl";
+
+// NOLINTNEXTLINE(hicpp-no-array-decay)
+using Program = Program<shader_vertex, shader_fragment, false>;
+
+// rows from top to bottom, bit 4 is the leftmost column
+struct Glyph {
+    char c;
+    std::array<uint8_t, 7> rows;
+};
+
+inline constexpr std::array<Glyph, 44> kFont{{
+    {'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
+    {'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
+    {'3', {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}},
+    {'4', {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}},
+    {'5', {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}},
+    {'6', {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}},
+    {'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+    {'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
+    {'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+    {'A', {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11}},
+    {'B', {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}},
+    {'C', {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}},
+    {'D', {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}},
+    {'E', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}},
+    {'F', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}},
+    {'G', {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}},
+    {'H', {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}},
+    {'I', {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {'J', {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}},
+    {'K', {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}},
+    {'L', {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}},
+    {'M', {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}},
+    {'N', {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}},
+    {'O', {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+    {'P', {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}},
+    {'Q', {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}},
+    {'R', {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}},
+    {'S', {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}},
+    {'T', {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}},
+    {'U', {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+    {'V', {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}},
+    {'W', {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}},
+    {'X', {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}},
+    {'Y', {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}},
+    {'Z', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}},
+    {'.', {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}},
+    {':', {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}},
+    {'/', {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}},
+    {'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
+    {'%', {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}},
+    {'(', {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}},
+    {')', {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}},
+    {'+', {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}},
+}};
+
+// 35 glyph bits, row r column c is bit r * 5 + (4 - c)
+[[nodiscard]] inline auto GlyphBits(char c) -> uint64_t {
+    if (c >= 'a' && c <= 'z') {
+        c = static_cast<char>(c - 'a' + 'A');
+    }
+    for (const auto &glyph : kFont) {
+        if (glyph.c != c) {
+            continue;
+        }
+        uint64_t bits = 0;
+        for (size_t row = 0; row < glyph.rows.size(); row++) {
+            bits |= static_cast<uint64_t>(glyph.rows[row]) << (5 * row);
+        }
+        return bits;
+    }
+    return 0;
+}
+
+class Overlay {
+   public:
+    static constexpr size_t kLines = 6;
+    static constexpr size_t kColumns = 24;
+    // background panel and one quad per character
+    static constexpr size_t kMaxQuads = 1 + (kLines * kColumns);
+    // size of a font pixel in screen pixels
+    static constexpr float kScale = 2.0F;
+    static constexpr auto kRefreshInterval = std::chrono::milliseconds(250);
+
+    Overlay() : vbo{kMaxQuads} { ConfigureVAO(); }
+
+    // count a frame that took cpu_ms on the CPU
+    void AddFrame(double cpu_ms) {
+        frames++;
+        cpu_ms_sum += cpu_ms;
+    }
+
+    [[nodiscard]] auto RefreshDue() const -> bool {
+        return Clock::now() - refreshed >= kRefreshInterval;
+    }
+
+    // rebuild the text from the frames added since the last refresh,
+    // gpu_ms is negative if GPU timing is unavailable
+    void Refresh(double gpu_ms, size_t gpu_bytes) {
+        const auto now = Clock::now();
+        const double seconds =
+            std::chrono::duration<double>(now - refreshed).count();
+        const double frame_count =
+            static_cast<double>((std::max)(frames, size_t{1}));
+
+        std::array<Line, kLines> lines{};
+        Format(lines[0], "FPS %.1f", static_cast<double>(frames) / seconds);
+        Format(lines[1], "CPU %.2f MS", cpu_ms_sum / frame_count);
+        if (gpu_ms >= 0.0) {
+            Format(lines[2], "GPU %.2f MS", gpu_ms);
+        } else {
+            Format(lines[2], "%s", "GPU -");
+        }
+        // call counts are compiled out without GLVISKIT_GL_COUNTERS
+        if (GLCallCounter::kEnabled) {
+            const auto counts = GLCallCounter::GetInstance().LastFrame();
+            Format(lines[3], "DRAWS %llu",
+                   static_cast<unsigned long long>(counts.draw_calls));
+            FormatBytes(lines[4], "UPLOAD", counts.uploaded_bytes);
+        } else {
+            Format(lines[3], "%s", "DRAWS -");
+            Format(lines[4], "%s", "UPLOAD -");
+        }
+        FormatBytes(lines[5], "GPU MEM", gpu_bytes);
+
+        Layout(lines);
+        Upload();
+
+        refreshed = now;
+        frames = 0;
+        cpu_ms_sum = 0.0;
+    }
+
+    // draw over everything, restores the default renderer state
+    void Render(const glm::vec2 &screen_size) {
+        if (count == 0) {
+            return;
+        }
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        program.Use();
+        program.SetScreenSize(screen_size);
+        vao.Bind();
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6,
+                              static_cast<GLsizei>(count));
+        GLVISKIT_COUNT_GL(draw_calls, 1);
+        vao.Unbind();
+
+        glDisable(GL_BLEND);
+        glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+    using Line = std::array<char, kColumns + 1>;
+
+    struct Quad {
+        // top left corner and size in pixels
+        glm::vec2 origin;
+        glm::vec2 size;
+        std::array<GLuint, 2> bits;
+        glm::vec4 color;
+    };
+
+    Program program;
+    VAO vao;
+    BufferObject<Quad> vbo;
+    std::array<Quad, kMaxQuads> quads{};
+    size_t count{0};
+
+    Clock::time_point refreshed{Clock::now()};
+    size_t frames{0};
+    double cpu_ms_sum{0.0};
+
+    template <typename... Args>
+    static void Format(Line &line, const char *format, Args... args) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        std::snprintf(line.data(), line.size(), format, args...);
+    }
+
+    static void FormatBytes(Line &line, const char *label, uint64_t bytes) {
+        auto value = static_cast<double>(bytes);
+        const char *unit = "B";
+        for (const char *next : {"KB", "MB", "GB"}) {
+            if (value < 1024.0) {
+                break;
+            }
+            value /= 1024.0;
+            unit = next;
+        }
+        Format(line, "%s %.1f %s", label, value, unit);
+    }
+
+    void Layout(const std::array<Line, kLines> &lines) {
+        constexpr float kMargin = 4.0F * kScale;
+        constexpr float kAdvance = 6.0F * kScale;
+        constexpr float kLineHeight = 9.0F * kScale;
+        const glm::vec2 kGlyphSize{5.0F * kScale, 7.0F * kScale};
+        const glm::vec4 kText{1.0F, 1.0F, 1.0F, 1.0F};
+        const glm::vec4 kPanel{0.0F, 0.0F, 0.0F, 0.6F};
+
+        // the panel comes first so the text is drawn over it
+        count = 1;
+        size_t columns = 0;
+        for (size_t row = 0; row < kLines; row++) {
+            size_t column = 0;
+            for (; column < kColumns && lines[row][column] != '\0'; column++) {
+                const uint64_t bits = GlyphBits(lines[row][column]);
+                if (bits == 0) {
+                    continue;
+                }
+                quads[count++] = Quad{
+                    {kMargin * 2.0F + kAdvance * static_cast<float>(column),
+                     kMargin * 2.0F + kLineHeight * static_cast<float>(row)},
+                    kGlyphSize,
+                    {static_cast<GLuint>(bits),
+                     static_cast<GLuint>(bits >> 32)},
+                    kText};
+            }
+            columns = (std::max)(columns, column);
+        }
+        quads[0] = Quad{
+            {kMargin, kMargin},
+            {kMargin * 2.0F + kAdvance * static_cast<float>(columns),
+             kMargin * 2.0F + kLineHeight * static_cast<float>(kLines)},
+            {~GLuint{0}, ~GLuint{0}},
+            kPanel};
+    }
+
+    void Upload() {
+        vbo.Bind();
+        glBufferSubData(GL_ARRAY_BUFFER, 0,
+                        static_cast<GLsizeiptr>(count * sizeof(Quad)),
+                        quads.data());
+        GLVISKIT_COUNT_GL(uploaded_bytes, count * sizeof(Quad));
+        vbo.Unbind();
+    }
+
+    void ConfigureVAO() {
+        vao.Bind();
+        vbo.Bind();
+        // NOLINTBEGIN(performance-no-int-to-ptr)
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Quad),
+                              (void *)offsetof(Quad, origin));
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Quad),
+                              (void *)offsetof(Quad, size));
+        glVertexAttribIPointer(2, 2, GL_UNSIGNED_INT, sizeof(Quad),
+                               (void *)offsetof(Quad, bits));
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Quad),
+                              (void *)offsetof(Quad, color));
+        // NOLINTEND(performance-no-int-to-ptr)
+        for (GLuint i = 0; i < 4; i++) {
+            glEnableVertexAttribArray(i);
+            // one quad per instance
+            glVertexAttribDivisor(i, 1);
+        }
+        vbo.Unbind();
+        vao.Unbind();
+    }
+};
+
+}  // namespace glviskit::hud
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace glviskit {
+
+// Memory held by buffers, reserved is what is allocated and used is what
+// holds elements, the difference mostly comes from power of two growth.
+// GPU sizes are what glviskit requested, drivers may round them up.
+struct MemoryReport {
+    // CPU side element vectors
+    size_t cpu_used_bytes{0};
+    size_t cpu_reserved_bytes{0};
+    // GPU buffer objects
+    size_t gpu_used_bytes{0};
+    size_t gpu_reserved_bytes{0};
+    // framebuffers, textures and readback buffers of windows
+    size_t target_bytes{0};
+    // object counts, vertex arrays exist once per buffer and context
+    size_t buffer_objects{0};
+    size_t vertex_arrays{0};
+    size_t render_buffers{0};
+
+    auto operator+=(const MemoryReport &other) -> MemoryReport & {
+        cpu_used_bytes += other.cpu_used_bytes;
+        cpu_reserved_bytes += other.cpu_reserved_bytes;
+        gpu_used_bytes += other.gpu_used_bytes;
+        gpu_reserved_bytes += other.gpu_reserved_bytes;
+        target_bytes += other.target_bytes;
+        buffer_objects += other.buffer_objects;
+        vertex_arrays += other.vertex_arrays;
+        render_buffers += other.render_buffers;
+        return *this;
+    }
+
+    [[nodiscard]] auto CPUBytes() const -> size_t {
+        return cpu_reserved_bytes;
+    }
+    [[nodiscard]] auto GPUBytes() const -> size_t {
+        return gpu_reserved_bytes + target_bytes;
+    }
+    // reserved but unused bytes on both sides
+    [[nodiscard]] auto SlackBytes() const -> size_t {
+        return (cpu_reserved_bytes - cpu_used_bytes) +
+               (gpu_reserved_bytes - gpu_used_bytes);
+    }
+};
+
+// memory of a vector holding T
+template <typename T>
+[[nodiscard]] auto VectorMemory(const std::vector<T> &vector) -> MemoryReport {
+    MemoryReport report;
+    report.cpu_used_bytes = vector.size() * sizeof(T);
+    report.cpu_reserved_bytes = vector.capacity() * sizeof(T);
+    return report;
+}
+
+// Memory of a RenderBuffer split by what holds it.
+struct RenderBufferMemory {
+    MemoryReport lines;
+    MemoryReport points;
+    MemoryReport circles;
+    MemoryReport instances;
+    // polyline starts and simplified levels, if line LOD is enabled
+    MemoryReport line_lod;
+    MemoryReport total;
+};
+
+}  // namespace glviskit
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "../gl/gl.hpp"
+#include "../gl/null.hpp"
+#include "../memory.hpp"
+#include "../recorder.hpp"
+#include "../render_buffer.hpp"
+#include "../render_thread.hpp"
+#include "../trace.hpp"
+#include "window.hpp"
+
+namespace glviskit::null {
+
+// Manager of the null GL backend, GLVISKIT_GL_TYPE=NONE.
+// Same interface as offscreen::Manager without SDL, there are no events,
+// so Loop only renders and never asks to quit.
+class Manager {
+   public:
+    // singleton access
+    static auto GetInstance() -> Manager & {
+        static Manager instance;
+        return instance;
+    }
+
+    Manager(const Manager &) = delete;
+    auto operator=(const Manager &) -> Manager & = delete;
+    Manager(Manager &&) = delete;
+    auto operator=(Manager &&) -> Manager & = delete;
+    ~Manager() = default;
+
+    auto CreateWindow(const char *title, int w, int h)
+        -> std::shared_ptr<Window> {
+        rendering_.EnsureNotThreaded("CreateWindow");
+        auto window = std::make_shared<Window>(title, w, h, next_window_id_++);
+        windows_.insert({window->GetWindowID(), window});
+        return window;
+    }
+
+    // with a render thread this publishes the recorded frame instead
+    auto Loop() -> bool {
+        TraceScope trace{"Manager::Loop"};
+        if (rendering_.Running()) {
+            Publish();
+        } else {
+            Render();
+        }
+        return true;
+    }
+
+    // render all windows, returns whether any window drew a frame
+    auto Render() -> bool { return rendering_.Render(); }
+
+    // Render on a thread of its own, see RenderThread. Windows and render
+    // buffers have to exist before it starts. While it runs, render buffers
+    // change only through Record: every buffer of a window is saved as it is
+    // and driven by frames from the start, so it shows that state and what
+    // was recorded for it, and changing it directly would race with the
+    // thread. Window cameras reach it with every frame and other window
+    // settings need it stopped.
+    void StartRenderThread() { rendering_.Start(); }
+    void StopRenderThread() { rendering_.Stop(); }
+
+    [[nodiscard]] auto RenderThreadRunning() const -> bool {
+        return rendering_.Running();
+    }
+
+    // recorder for the contents of buffer in the next published frame
+    auto Record(const std::shared_ptr<RenderBuffer> &buffer) -> Recorder & {
+        return rendering_.Record(buffer);
+    }
+
+    // hand the recorded frame and the cameras to the render thread
+    void Publish() { rendering_.Publish(); }
+
+    void SetRenderOnDemand(bool enabled) {
+        rendering_.SetRenderOnDemand(enabled);
+    }
+    [[nodiscard]] auto GetRenderOnDemand() const -> bool {
+        return rendering_.GetRenderOnDemand();
+    }
+
+    // memory of all windows and live render buffers, attached to a window
+    // or not, render buffers shared between windows are only counted once,
+    // the render thread changes it with every frame
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        return rendering_.MemoryUsage(buffers_);
+    }
+
+    auto CreateRenderBuffer() -> std::shared_ptr<RenderBuffer> {
+        rendering_.EnsureNotThreaded("CreateRenderBuffer");
+        auto buffer = std::make_shared<RenderBuffer>();
+        // drop buffers that are gone, the list only grows with live ones
+        std::erase_if(buffers_, [](const auto &created) {
+            return created.expired();
+        });
+        buffers_.push_back(buffer);
+        return buffer;
+    }
+
+    static auto GetTimeSeconds() -> float {
+        static const auto start = std::chrono::steady_clock::now();
+        return std::chrono::duration<float>(std::chrono::steady_clock::now() -
+                                            start)
+            .count();
+    }
+
+   private:
+    std::map<GLuint, std::shared_ptr<Window>> windows_;
+    // every render buffer created, for MemoryUsage
+    std::vector<std::weak_ptr<RenderBuffer>> buffers_;
+    GLuint next_window_id_{1};
+    // last member, so the render thread stops before the windows go away
+    WindowRendering<std::map<GLuint, std::shared_ptr<Window>>> rendering_{
+        windows_};
+
+    // render buffers need GL before any window exists, so load it here
+    Manager() {
+        NullGL::Load();
+        GetTimeSeconds();
+    }
+
+};
+
+}  // namespace glviskit::null
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../gl/gl.hpp"
+#include "../gl/pixel_reader.hpp"
+#include "../gl/state.hpp"
+#include "../trace.hpp"
+#include "../render_thread.hpp"
+#include "../renderer.hpp"
+
+namespace glviskit::null {
+
+// Window of the null GL backend with the interface of offscreen::Window.
+// There is no context and no framebuffer, rendering runs the whole CPU side
+// of the renderer against the null GL stubs and read back frames are black.
+class Window {
+   public:
+    Window(const char *title, int w, int h, GLuint window_id)
+        : window_id_{window_id}, width_{w}, height_{h} {
+        (void)title;
+    }
+
+    void AddRenderBuffer(const std::shared_ptr<RenderBuffer> &render_buffer) {
+        thread_state_.EnsureNotThreaded("AddRenderBuffer");
+        renderer.AddRenderBuffer(render_buffer);
+        damaged_ = true;
+    }
+
+    // with a render thread the renderer draws with a copy of this camera
+    // taken by every published frame
+    auto GetCamera() -> std::shared_ptr<Camera> {
+        return thread_state_.GetCamera();
+    }
+    void SetCamera(std::shared_ptr<Camera> cam) {
+        if (thread_state_.SetCamera(renderer, std::move(cam))) {
+            damaged_ = true;
+        }
+    }
+
+    void SetTransparency(Transparency mode) {
+        thread_state_.EnsureNotThreaded("SetTransparency");
+        renderer.SetTransparency(mode);
+        damaged_ = true;
+    }
+    [[nodiscard]] auto GetTransparency() const -> Transparency {
+        return renderer.GetTransparency();
+    }
+
+    // performance overlay
+    void SetHUD(bool enabled) {
+        thread_state_.EnsureNotThreaded("SetHUD");
+        renderer.SetHUD(enabled);
+        damaged_ = true;
+    }
+    [[nodiscard]] auto GetHUD() const -> bool {
+        thread_state_.EnsureNotThreaded("GetHUD");
+        return renderer.GetHUD();
+    }
+
+    // null timer queries measure zero
+    void SetGPUTiming(bool enabled, bool per_buffer = false) {
+        thread_state_.EnsureNotThreaded("SetGPUTiming");
+        renderer.SetGPUTiming(enabled, per_buffer);
+    }
+    [[nodiscard]] auto GetFrameStats() const -> const FrameStats & {
+        thread_state_.EnsureNotThreaded("GetFrameStats");
+        return renderer.GetFrameStats();
+    }
+
+    void SetSize(int w, int h) {
+        thread_state_.EnsureNotThreaded("SetSize");
+        width_ = w;
+        height_ = h;
+        damaged_ = true;
+    }
+    [[nodiscard]] auto GetWidth() const -> int { return width_; }
+    [[nodiscard]] auto GetHeight() const -> int { return height_; }
+
+    // there is no context, only the binding cache of the window
+    void MakeCurrent() { gl_state_.MakeCurrent(); }
+
+    void Render() {
+        TraceScope trace{"Window::Render"};
+        MakeCurrent();
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderer.Render(window_id_, width_, height_);
+
+        if (pixel_reader_) {
+            pixel_reader_->Queue(width_, height_, frame_index_);
+        }
+        frame_index_++;
+
+        rendered_generation_ = renderer.Generation();
+        damaged_ = false;
+    }
+
+    // render only if the contents are out of date,
+    // returns whether a frame was drawn
+    auto RenderIfChanged() -> bool {
+        if (!damaged_ && renderer.Generation() == rendered_generation_) {
+            return false;
+        }
+        Render();
+        return true;
+    }
+
+    [[nodiscard]] auto ReadPixels() -> std::vector<uint8_t> {
+        thread_state_.EnsureNotThreaded("ReadPixels");
+        return std::vector<uint8_t>(static_cast<size_t>(width_) *
+                                    static_cast<size_t>(height_) * 4);
+    }
+
+    // same protocol as offscreen::Window, frames are ready immediately
+    auto ReadPixelsAsync() -> std::shared_ptr<PixelFrame> {
+        thread_state_.EnsureNotThreaded("ReadPixelsAsync");
+        MakeCurrent();
+        if (!pixel_reader_) {
+            pixel_reader_ = std::make_unique<PixelReader>();
+            return nullptr;
+        }
+        return pixel_reader_->Poll();
+    }
+
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        thread_state_.EnsureNotThreaded("MemoryUsage");
+        MemoryReport report = renderer.MemoryUsage();
+        report.target_bytes = TargetMemoryBytes();
+        return report;
+    }
+
+    [[nodiscard]] auto TargetMemoryBytes() const -> size_t {
+        size_t bytes = renderer.TargetMemoryBytes();
+        if (pixel_reader_) {
+            bytes += pixel_reader_->MemoryBytes();
+        }
+        return bytes;
+    }
+
+    [[nodiscard]] auto GetWindowID() const -> GLuint { return window_id_; }
+
+   private:
+    GLState gl_state_;
+    Renderer renderer;
+    GLuint window_id_;
+
+    WindowThreadState thread_state_{renderer};
+
+    std::unique_ptr<PixelReader> pixel_reader_{nullptr};
+    uint64_t frame_index_{0};
+
+    int width_;
+    int height_;
+
+    // render on demand state
+    uint64_t rendered_generation_{0};
+    std::atomic<bool> damaged_{true};
+
+    // called by the manager while no render thread runs
+    void SetThreaded(bool threaded) {
+        thread_state_.SetThreaded(renderer, threaded);
+        damaged_ = true;
+    }
+
+    // user thread
+    void PublishCamera(Frame &frame) {
+        thread_state_.Publish(
+            window_id_,
+            {static_cast<float>(width_), static_cast<float>(height_)}, frame);
+    }
+
+    // render thread
+    void ApplyFrame(const Frame &frame) {
+        if (thread_state_.Apply(window_id_, frame, renderer)) {
+            damaged_ = true;
+        }
+    }
+
+    // there is no context to hand over to the render thread
+    void ReleaseContext() {}
+
+    friend class Manager;
+    template <typename>
+    friend class glviskit::WindowRendering;
+};
+
+}  // namespace glviskit::null
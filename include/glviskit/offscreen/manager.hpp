@@ -0,0 +1,203 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "../gl/debug.hpp"
+#include "../gl/gl.hpp"
+#include "../memory.hpp"
+#include "../profiler.hpp"
+#include "../recorder.hpp"
+#include "../render_buffer.hpp"
+#include "../render_thread.hpp"
+#include "../trace.hpp"
+#include "../sdl/context.hpp"
+#include "../sdl/sdl.hpp"
+#include "window.hpp"
+
+namespace glviskit::offscreen {
+
+// Headless counterpart of sdl::Manager with the same interface.
+// SDL is initialized with its offscreen video driver, so no display
+// server is needed and GL contexts are created through EGL.
+class Manager {
+   public:
+    // singleton access
+    static auto GetInstance() -> Manager & {
+        static Manager instance;
+        return instance;
+    }
+
+    Manager(const Manager &) = delete;
+    auto operator=(const Manager &) -> Manager & = delete;
+    Manager(Manager &&) = delete;
+    auto operator=(Manager &&) -> Manager & = delete;
+
+    ~Manager() {
+        StopRenderThread();
+        windows_.clear();
+
+        SDL_Quit();
+    }
+
+    auto CreateWindow(const char *title, int w, int h)
+        -> std::shared_ptr<Window> {
+        rendering_.EnsureNotThreaded("CreateWindow");
+        std::shared_ptr<Window> window;
+
+        if (!windows_.empty()) {
+            auto any_window = GetAnyWindow();
+            any_window->MakeCurrent();
+            window = std::make_shared<Window>(title, w, h, true);
+        } else {
+            window = std::make_shared<Window>(title, w, h, false);
+            window->MakeCurrent();
+            sdl::LoadGLAD();
+        }
+
+        // the new window's context is current here
+        EnableDebugOutput();
+
+        windows_.insert({window->GetWindowID(), window});
+        return window;
+    }
+
+    // there is nothing to present or wait for, so this only renders
+    // and drains the event queue, with a render thread it publishes the
+    // recorded frame instead of rendering
+    auto Loop() -> bool {
+        TraceScope trace{"Manager::Loop"};
+        if (rendering_.Running()) {
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                if (!ProcessEvent(event)) {
+                    return false;
+                }
+            }
+            Publish();
+            return true;
+        }
+
+        auto &profiler = Profiler::GetInstance();
+        profiler.BeginFrame();
+        bool rendered = rendering_.RenderWindows();
+
+        {
+            ScopedTimer timer{Profiler::Stage::Events};
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                if (!ProcessEvent(event)) {
+                    return false;
+                }
+            }
+        }
+
+        profiler.EndFrame(rendered);
+        return true;
+    }
+
+    // render all windows, returns whether any window drew a frame
+    auto Render() -> bool { return rendering_.Render(); }
+
+    // Render on a thread of its own that takes over the GL contexts, see
+    // RenderThread. Windows and render buffers have to exist before it
+    // starts. While it runs, render buffers change only through Record:
+    // every buffer of a window is saved as it is and driven by frames from
+    // the start, so it shows that state and what was recorded for it, and
+    // changing it directly would race with the thread. Window cameras
+    // reach it with every frame and other window settings, reading pixels
+    // included, need it stopped.
+    void StartRenderThread() { rendering_.Start(); }
+    void StopRenderThread() { rendering_.Stop(); }
+
+    [[nodiscard]] auto RenderThreadRunning() const -> bool {
+        return rendering_.Running();
+    }
+
+    // recorder for the contents of buffer in the next published frame
+    auto Record(const std::shared_ptr<RenderBuffer> &buffer) -> Recorder & {
+        return rendering_.Record(buffer);
+    }
+
+    // hand the recorded frame and the cameras to the render thread
+    void Publish() { rendering_.Publish(); }
+
+    // batch jobs usually want every requested frame, so this is off
+    void SetRenderOnDemand(bool enabled) {
+        rendering_.SetRenderOnDemand(enabled);
+    }
+    [[nodiscard]] auto GetRenderOnDemand() const -> bool {
+        return rendering_.GetRenderOnDemand();
+    }
+
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    auto ProcessEvent(const SDL_Event &event) -> bool {
+        return event.type != SDL_EVENT_QUIT;
+    }
+
+    // memory of all windows and live render buffers, attached to a window
+    // or not, render buffers shared between windows are only counted once,
+    // the render thread changes it with every frame
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        return rendering_.MemoryUsage(buffers_);
+    }
+
+    auto CreateRenderBuffer() -> std::shared_ptr<RenderBuffer> {
+        rendering_.EnsureNotThreaded("CreateRenderBuffer");
+        EnsureContext();
+        auto buffer = std::make_shared<RenderBuffer>();
+        // drop buffers that are gone, the list only grows with live ones
+        std::erase_if(buffers_, [](const auto &created) {
+            return created.expired();
+        });
+        buffers_.push_back(buffer);
+        return buffer;
+    }
+
+    static auto GetTimeSeconds() -> float {
+        return static_cast<float>(SDL_GetTicks()) / 1000.0F;
+    }
+
+   private:
+    std::map<Uint32, std::shared_ptr<Window>> windows_;
+    // every render buffer created, for MemoryUsage
+    std::vector<std::weak_ptr<RenderBuffer>> buffers_;
+    WindowRendering<std::map<Uint32, std::shared_ptr<Window>>> rendering_{
+        windows_};
+
+    Manager() {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+        if (!SDL_Init(SDL_INIT_VIDEO)) {
+            std::cerr << "Failed to initialize SDL: " << SDL_GetError() << '\n';
+            exit(EXIT_FAILURE);
+        }
+        if (!SDL_GL_LoadLibrary(nullptr)) {
+            std::cerr << "Failed to load EGL: " << SDL_GetError() << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        sdl::SetGLAttributes();
+        // windows render into their own multisampled framebuffer objects,
+        // the surface itself is never drawn to
+        SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 0);
+        SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 0);
+    }
+
+    // get any active window (for context sharing)
+    auto GetAnyWindow() -> std::shared_ptr<Window> {
+        EnsureContext();
+        return windows_.begin()->second;
+    }
+
+    void EnsureContext() {
+        if (windows_.empty()) {
+            throw std::runtime_error(
+                "No context initialized, create a window first");
+        }
+    }
+};
+
+}  // namespace glviskit::offscreen
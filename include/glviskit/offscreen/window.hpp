@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../gl/framebuffer.hpp"
+#include "../gl/gl.hpp"
+#include "../gl/pixel_reader.hpp"
+#include "../gl/state.hpp"
+#include "../profiler.hpp"
+#include "../trace.hpp"
+#include "../render_thread.hpp"
+#include "../renderer.hpp"
+#include "../sdl/sdl.hpp"
+
+namespace glviskit::offscreen {
+
+// A window that never reaches a display.
+// The GL context belongs to a hidden SDL window on the EGL based offscreen
+// video driver, which also runs on software rasterizers such as llvmpipe.
+// Frames are rendered into a multisampled framebuffer object and resolved
+// into a single sampled one for reading, there is no swap and no vsync.
+class Window {
+   public:
+    Window(const char *title, int w, int h, bool share_context)
+        : window_{nullptr}, context_{nullptr}, width_{w}, height_{h} {
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT,
+                            share_context ? 1 : 0);
+
+        auto *handle = SDL_CreateWindow(title, w, h,
+                                        SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+        if (handle == nullptr) {
+            std::cerr << "Failed to create offscreen window: "
+                      << SDL_GetError() << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        window_ = sdl::SDLWindowPtr(handle);
+        window_id_ = SDL_GetWindowID(window_.Get());
+
+        context_ = sdl::SDLGLContextPtr(SDL_GL_CreateContext(window_.Get()));
+        if (context_.Get() == nullptr) {
+            std::cerr << "Failed to create offscreen GL context: "
+                      << SDL_GetError() << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        MakeCurrent();
+        // frames are never presented, make sure nothing waits for vsync
+        SDL_GL_SetSwapInterval(0);
+    }
+
+    void AddRenderBuffer(const std::shared_ptr<RenderBuffer> &render_buffer) {
+        thread_state_.EnsureNotThreaded("AddRenderBuffer");
+        renderer.AddRenderBuffer(render_buffer);
+        damaged_ = true;
+    }
+
+    // with a render thread the renderer draws with a copy of this camera
+    // taken by every published frame
+    auto GetCamera() -> std::shared_ptr<Camera> {
+        return thread_state_.GetCamera();
+    }
+    void SetCamera(std::shared_ptr<Camera> cam) {
+        if (thread_state_.SetCamera(renderer, std::move(cam))) {
+            damaged_ = true;
+        }
+    }
+
+    void SetTransparency(Transparency mode) {
+        thread_state_.EnsureNotThreaded("SetTransparency");
+        renderer.SetTransparency(mode);
+        damaged_ = true;
+    }
+    [[nodiscard]] auto GetTransparency() const -> Transparency {
+        return renderer.GetTransparency();
+    }
+
+    // performance overlay
+    void SetHUD(bool enabled) {
+        thread_state_.EnsureNotThreaded("SetHUD");
+        renderer.SetHUD(enabled);
+        damaged_ = true;
+    }
+    [[nodiscard]] auto GetHUD() const -> bool {
+        thread_state_.EnsureNotThreaded("GetHUD");
+        return renderer.GetHUD();
+    }
+
+    void SetGPUTiming(bool enabled, bool per_buffer = false) {
+        thread_state_.EnsureNotThreaded("SetGPUTiming");
+        renderer.SetGPUTiming(enabled, per_buffer);
+    }
+    [[nodiscard]] auto GetFrameStats() const -> const FrameStats & {
+        thread_state_.EnsureNotThreaded("GetFrameStats");
+        return renderer.GetFrameStats();
+    }
+
+    // framebuffer size in pixels, reallocated on the next render
+    void SetSize(int w, int h) {
+        thread_state_.EnsureNotThreaded("SetSize");
+        width_ = w;
+        height_ = h;
+        damaged_ = true;
+    }
+    [[nodiscard]] auto GetWidth() const -> int { return width_; }
+    [[nodiscard]] auto GetHeight() const -> int { return height_; }
+
+    void MakeCurrent() {
+        SDL_GL_MakeCurrent(window_.Get(), context_.Get());
+        gl_state_.MakeCurrent();
+    }
+
+    void Render() {
+        TraceScope trace{"Window::Render"};
+
+        // make context current
+        // renderer expects the context to be current
+        bool ret = SDL_GL_MakeCurrent(window_.Get(), context_.Get());
+        if (!ret) {
+            std::cerr << "Failed to make context current: " << SDL_GetError()
+                      << '\n';
+            exit(EXIT_FAILURE);
+        }
+        gl_state_.MakeCurrent();
+
+        EnsureFramebuffers();
+
+        // do rendering
+        targets_->msaa_framebuffer.Bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderer.Render(window_id_, width_, height_);
+
+        // resolve multisampling, the result stays bound for reading,
+        // profiled as the swap since it takes its place
+        {
+            ScopedTimer timer{Profiler::Stage::Swap};
+            targets_->msaa_framebuffer.Bind(GL_READ_FRAMEBUFFER);
+            targets_->resolve_framebuffer.Bind(GL_DRAW_FRAMEBUFFER);
+            glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            targets_->resolve_framebuffer.Bind();
+        }
+
+        if (pixel_reader_) {
+            pixel_reader_->Queue(width_, height_, frame_index_);
+        }
+        frame_index_++;
+
+        rendered_generation_ = renderer.Generation();
+        damaged_ = false;
+    }
+
+    // render only if the contents are out of date,
+    // returns whether a frame was drawn
+    auto RenderIfChanged() -> bool {
+        if (!damaged_ && renderer.Generation() == rendered_generation_) {
+            return false;
+        }
+        Render();
+        return true;
+    }
+
+    // blocking readback of the last frame as RGBA rows, top row first
+    [[nodiscard]] auto ReadPixels() -> std::vector<uint8_t> {
+        thread_state_.EnsureNotThreaded("ReadPixels");
+        MakeCurrent();
+        EnsureFramebuffers();
+
+        const auto row = static_cast<size_t>(width_) * 4;
+        std::vector<uint8_t> pixels(row * static_cast<size_t>(height_));
+        targets_->resolve_framebuffer.Bind(GL_READ_FRAMEBUFFER);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
+                     pixels.data());
+
+        // GL rows start at the bottom
+        const auto rows = static_cast<size_t>(height_);
+        for (size_t top = 0; top < rows / 2; top++) {
+            auto top_row = pixels.begin() + static_cast<ptrdiff_t>(top * row);
+            auto bottom_row = pixels.begin() +
+                              static_cast<ptrdiff_t>((rows - 1 - top) * row);
+            std::swap_ranges(top_row, top_row + static_cast<ptrdiff_t>(row),
+                             bottom_row);
+        }
+        return pixels;
+    }
+
+    // Starts reading frames back on the first call, which returns nullptr.
+    // Later calls return the newest frame whose readback finished, usually
+    // one or two frames old, or nullptr if none finished since the last
+    // call. Never waits for the GPU.
+    auto ReadPixelsAsync() -> std::shared_ptr<PixelFrame> {
+        thread_state_.EnsureNotThreaded("ReadPixelsAsync");
+        MakeCurrent();
+        if (!pixel_reader_) {
+            pixel_reader_ = std::make_unique<PixelReader>();
+            return nullptr;
+        }
+        return pixel_reader_->Poll();
+    }
+
+    // render buffers may be shared with other windows and are counted
+    // in each of them, see Manager::MemoryUsage for a deduplicated total
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        thread_state_.EnsureNotThreaded("MemoryUsage");
+        MemoryReport report = renderer.MemoryUsage();
+        report.target_bytes = TargetMemoryBytes();
+        return report;
+    }
+
+    // framebuffer and readback memory owned by the window
+    [[nodiscard]] auto TargetMemoryBytes() const -> size_t {
+        size_t bytes = renderer.TargetMemoryBytes();
+        if (pixel_reader_) {
+            bytes += pixel_reader_->MemoryBytes();
+        }
+        if (targets_) {
+            // multisampled color and depth plus the resolved color
+            const auto pixels = static_cast<size_t>(allocated_width_) *
+                                static_cast<size_t>(allocated_height_);
+            bytes += pixels * ((4 + 4) * kSamples + 4);
+        }
+        return bytes;
+    }
+
+    [[nodiscard]] auto GetWindowID() const -> Uint32 { return window_id_; }
+
+   private:
+    static constexpr int kSamples = 4;
+
+    sdl::SDLWindowPtr window_;
+    sdl::SDLGLContextPtr context_;
+
+    // bindings of this window's context
+    GLState gl_state_;
+    Renderer renderer;
+    GLuint window_id_;
+
+    WindowThreadState thread_state_{renderer};
+
+    // asynchronous readback, created by the first ReadPixelsAsync
+    std::unique_ptr<PixelReader> pixel_reader_{nullptr};
+    uint64_t frame_index_{0};
+
+    // render targets, created on first use since GL may not be loaded
+    // yet when the window is constructed
+    struct Targets {
+        Framebuffer msaa_framebuffer;
+        Framebuffer resolve_framebuffer;
+        Renderbuffer msaa_color;
+        Renderbuffer msaa_depth;
+        Renderbuffer resolve_color;
+    };
+    std::unique_ptr<Targets> targets_{nullptr};
+    int width_;
+    int height_;
+    int allocated_width_{0};
+    int allocated_height_{0};
+
+    // render on demand state
+    uint64_t rendered_generation_{0};
+    std::atomic<bool> damaged_{true};
+
+    void EnsureFramebuffers() {
+        if (!targets_) {
+            targets_ = std::make_unique<Targets>();
+        } else if (width_ == allocated_width_ &&
+                   height_ == allocated_height_) {
+            return;
+        }
+
+        auto &[msaa_framebuffer, resolve_framebuffer, msaa_color, msaa_depth,
+               resolve_color] = *targets_;
+        msaa_color.Allocate(GL_RGBA8, width_, height_, kSamples);
+        msaa_depth.Allocate(GL_DEPTH_COMPONENT24, width_, height_, kSamples);
+        msaa_framebuffer.Bind();
+        msaa_framebuffer.Attach(GL_COLOR_ATTACHMENT0, msaa_color);
+        msaa_framebuffer.Attach(GL_DEPTH_ATTACHMENT, msaa_depth);
+        bool complete = msaa_framebuffer.Complete();
+
+        resolve_color.Allocate(GL_RGBA8, width_, height_);
+        resolve_framebuffer.Bind();
+        resolve_framebuffer.Attach(GL_COLOR_ATTACHMENT0, resolve_color);
+        complete = complete && resolve_framebuffer.Complete();
+
+        if (!complete) {
+            std::cerr << "Failed to create offscreen framebuffer" << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        allocated_width_ = width_;
+        allocated_height_ = height_;
+    }
+
+    // called by the manager while no render thread runs
+    void SetThreaded(bool threaded) {
+        thread_state_.SetThreaded(renderer, threaded);
+        damaged_ = true;
+    }
+
+    // user thread
+    void PublishCamera(Frame &frame) {
+        thread_state_.Publish(
+            window_id_,
+            {static_cast<float>(width_), static_cast<float>(height_)}, frame);
+    }
+
+    // render thread
+    void ApplyFrame(const Frame &frame) {
+        if (thread_state_.Apply(window_id_, frame, renderer)) {
+            damaged_ = true;
+        }
+    }
+
+    // a context is current on one thread at a time
+    void ReleaseContext() { SDL_GL_MakeCurrent(window_.Get(), nullptr); }
+
+    friend class Manager;
+    template <typename>
+    friend class glviskit::WindowRendering;
+};
+
+}  // namespace glviskit::offscreen
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace glviskit {
+
+// Split [0, count) into contiguous ranges and call func(begin, end) for each
+// range on its own thread. Small workloads run inline on the calling thread.
+template <typename F>
+void ParallelFor(size_t count, size_t min_per_thread, F &&func) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t hw = (std::max)(std::thread::hardware_concurrency(), 1U);
+    size_t threads =
+        (std::min)(hw, (count + min_per_thread - 1) / min_per_thread);
+    if (threads <= 1) {
+        func(size_t{0}, count);
+        return;
+    }
+
+    size_t chunk = (count + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; t++) {
+        size_t begin = t * chunk;
+        size_t end = (std::min)(begin + chunk, count);
+        if (begin >= end) {
+            break;
+        }
+        workers.emplace_back([&func, begin, end]() { func(begin, end); });
+    }
+
+    // first range runs on the calling thread
+    func(size_t{0}, (std::min)(chunk, count));
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+}  // namespace glviskit
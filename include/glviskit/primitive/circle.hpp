@@ -1,14 +1,19 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <map>
 
 #include "../gl/buffer_stack.hpp"
+#include "../gl/counters.hpp"
 #include "../gl/gl.hpp"
 #include "../gl/instance.hpp"
+#include "../gl/oit.hpp"
 #include "../gl/program.hpp"
 #include "../gl/vao.hpp"
+#include "../memory.hpp"
+#include "../profiler.hpp"
 
 namespace glviskit::circle {
 
@@ -61,6 +66,28 @@ inline constexpr char shader_fragment[] = GLVISKIT_FRAG_HEADER R"glsl(
     }
 )glsl";
 
+// weighted blended transparency variant, see gl/oit.hpp
+// NOLINTNEXTLINE(hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+inline constexpr char shader_fragment_oit[] =
+    GLVISKIT_FRAG_HEADER GLVISKIT_OIT_FRAG_OUTPUT R"glsl(
+    in vec4 v_color;
+    in float v_radius;
+    in vec2 v_offset;
+
+    void main() {
+        float dist = length(v_offset);
+        if (dist > v_radius) {
+            discard;
+        }
+
+        float delta = fwidth(dist);
+        float alpha = 1.0 - smoothstep(v_radius - delta, v_radius, dist);
+        oit_output(vec4(v_color.rgb, v_color.a * alpha));
+    }
+)glsl";
+
+// NOLINTNEXTLINE(hicpp-no-array-decay)
+using ProgramOIT = glviskit::Program<shader_vertex, shader_fragment_oit>;
 // NOLINTNEXTLINE(hicpp-no-array-decay)
 using Program = Program<shader_vertex, shader_fragment>;
 
@@ -74,6 +101,26 @@ class Buffer {
 
     explicit Buffer(InstanceBuffer &vbo_inst) : vbo_inst{vbo_inst} {}
 
+    // append the quad of a circle to any element and index containers with
+    // Size and Append
+    template <typename VBO, typename EBO>
+    static void AppendCircle(VBO &vbo, EBO &ebo, const glm::vec3 &circle,
+                             const glm::vec4 &c, float s) {
+        auto index = static_cast<GLuint>(vbo.Size());
+        // four vertices
+        vbo.Append({.circle = circle, .position = {-s, -s, 0}, .color = c});
+        vbo.Append({.circle = circle, .position = {s, -s, 0}, .color = c});
+        vbo.Append({.circle = circle, .position = {s, s, 0}, .color = c});
+        vbo.Append({.circle = circle, .position = {-s, s, 0}, .color = c});
+        // two triangles
+        ebo.Append(index + 0);
+        ebo.Append(index + 1);
+        ebo.Append(index + 2);
+        ebo.Append(index + 2);
+        ebo.Append(index + 3);
+        ebo.Append(index + 0);
+    }
+
     void Render(GLuint ctx_id) {
         if (ebo.Size() == 0 || vbo_inst.Size() == 0) {
             return;
@@ -87,15 +134,15 @@ class Buffer {
         }
 
         if (!vao_configured.at(ctx_id)) {
+            ScopedTimer timer{Profiler::Stage::ConfigureVAO};
             ConfigureVAO(ctx_id);
             vao_configured.at(ctx_id) = true;
         }
 
+        ScopedTimer timer{Profiler::Stage::Draw};
         auto &vao = vaos.at(ctx_id);
         vao.Bind();
-        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(ebo.Size()),
-                                GL_UNSIGNED_INT, nullptr,
-                                static_cast<GLsizei>(vbo_inst.Size()));
+        DrawElementsInstanced(GL_TRIANGLES, vbo, ebo, vbo_inst);
         vao.Unbind();
     }
 
@@ -117,12 +164,22 @@ class Buffer {
     auto VBO() -> auto & { return vbo; }
     auto EBO() -> auto & { return ebo; }
 
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        return PrimitiveMemory(vbo, ebo, vaos);
+    }
+
+    [[nodiscard]] auto Generation() const -> uint64_t {
+        return vbo.Generation() + ebo.Generation();
+    }
+
    private:
     std::map<GLuint, bool> vao_configured;
     std::map<GLuint, VAO> vaos;
     BufferStack<Element, GL_ARRAY_BUFFER> vbo;
     BufferStack<GLuint, GL_ELEMENT_ARRAY_BUFFER> ebo;
     InstanceBuffer &vbo_inst;
+    // storage of the instance buffer the vertex arrays point into
+    uint64_t instance_storage{};
 
     void ConfigureVAO(GLuint ctx_id) {
         VAO &vao = vaos.at(ctx_id);
@@ -144,10 +201,12 @@ class Buffer {
 
         vbo_inst.Bind();
         std::size_t vec4_size = sizeof(glm::vec4);
+        std::size_t instance_offset = vbo_inst.Offset() * sizeof(Instance);
         for (int i = 0; i < 4; i++) {
             glVertexAttribPointer(
                 3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
-                (void *)(offsetof(Instance, transform) + (vec4_size * i)));
+                (void *)(instance_offset + offsetof(Instance, transform) +
+                         (vec4_size * i)));
             glEnableVertexAttribArray(3 + i);
             glVertexAttribDivisor(3 + i, 1);
         }
@@ -160,7 +219,11 @@ class Buffer {
     auto Sync() -> bool {
         bool re_vbo = vbo.Sync();
         bool re_ebo = ebo.Sync();
-        bool re_vbo_inst = vbo_inst.Sync();
+        vbo_inst.Sync();
+        // the instance buffer is shared, so it may have been moved by the
+        // sync of another buffer
+        bool re_vbo_inst = vbo_inst.Storage() != instance_storage;
+        instance_storage = vbo_inst.Storage();
         bool reallocated = re_vbo || re_ebo || re_vbo_inst;
         return reallocated;
     }
@@ -1,14 +1,23 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <map>
+#include <span>
+#include <type_traits>
+#include <vector>
 
 #include "../gl/buffer_stack.hpp"
+#include "../gl/counters.hpp"
 #include "../gl/gl.hpp"
 #include "../gl/instance.hpp"
 #include "../gl/program.hpp"
 #include "../gl/vao.hpp"
+#include "../memory.hpp"
+#include "../parallel.hpp"
+#include "../profiler.hpp"
 
 namespace glviskit::line {
 
@@ -90,18 +99,150 @@ class Buffer {
         }
 
         if (!vao_configured.at(ctx_id)) {
+            ScopedTimer timer{Profiler::Stage::ConfigureVAO};
             ConfigureVAO(ctx_id);
             vao_configured.at(ctx_id) = true;
         }
 
+        ScopedTimer timer{Profiler::Stage::Draw};
         auto &vao = vaos.at(ctx_id);
         vao.Bind();
-        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(ebo.Size()),
-                                GL_UNSIGNED_INT, nullptr,
-                                static_cast<GLsizei>(vbo_inst.Size()));
+        DrawElementsInstanced(GL_TRIANGLES, vbo, ebo, vbo_inst);
         vao.Unbind();
     }
 
+    // append a segment between two polyline vertices, joining it to the
+    // previous segment when it continues the same polyline
+    void AppendSegment(const glm::vec3 &p0, const glm::vec4 &c0, float s0,
+                       const glm::vec3 &p1, const glm::vec4 &c1, float s1,
+                       bool connect) {
+        AppendSegment(vbo, ebo, p0, c0, s0, p1, c1, s1, connect);
+    }
+
+    // same for any element and index containers with Size and Append
+    template <typename VBO, typename EBO>
+    static void AppendSegment(VBO &vbo, EBO &ebo, const glm::vec3 &p0,
+                              const glm::vec4 &c0, float s0,
+                              const glm::vec3 &p1, const glm::vec4 &c1,
+                              float s1, bool connect) {
+        auto base_index = static_cast<GLuint>(vbo.Size());
+
+        auto direction = p1 - p0;
+        // vertices for new line segment
+        vbo.Append(
+            {.position = p0, .velocity = direction, .color = c0, .size = s0});
+        vbo.Append(
+            {.position = p0, .velocity = direction, .color = c0, .size = -s0});
+        vbo.Append(
+            {.position = p1, .velocity = direction, .color = c1, .size = s1});
+        vbo.Append(
+            {.position = p1, .velocity = direction, .color = c1, .size = -s1});
+
+        // new line segment
+        ebo.Append(base_index + 0);
+        ebo.Append(base_index + 2);
+        ebo.Append(base_index + 1);
+        ebo.Append(base_index + 1);
+        ebo.Append(base_index + 2);
+        ebo.Append(base_index + 3);
+
+        if (connect) {
+            // connect previous segment
+            // we have +0, +1 from new segment and -2, -1 from previous segment
+            ebo.Append(base_index - 2);
+            ebo.Append(base_index + 0);
+            ebo.Append(base_index - 1);
+            ebo.Append(base_index - 1);
+            ebo.Append(base_index + 0);
+            ebo.Append(base_index + 1);
+        }
+    }
+
+    // Append many polylines at once, polyline p are the vertices
+    // [starts[p], ends[p]) returned by source(i), each with position, color
+    // and size. Every segment has a fixed place in the buffers given by
+    // prefix sums of the segment counts, so ranges of segments are written
+    // in parallel, each by its own copy of source reading every vertex of
+    // the range once and in order.
+    template <typename Source>
+    void AppendPolylines(const Source &source, std::span<const size_t> starts,
+                         std::span<const size_t> ends) {
+        using V = std::remove_cvref_t<std::invoke_result_t<Source &, size_t>>;
+        // first segment of every polyline, and the total at the end
+        std::vector<size_t> first_segment(starts.size() + 1, 0);
+        // first index of every polyline, segments after the first are
+        // joined to the previous one with 6 more indices
+        std::vector<size_t> first_index(starts.size() + 1, 0);
+        for (size_t p = 0; p < starts.size(); p++) {
+            size_t segments =
+                ends[p] > starts[p] + 1 ? ends[p] - starts[p] - 1 : 0;
+            size_t joins = segments > 0 ? segments - 1 : 0;
+            first_segment[p + 1] = first_segment[p] + segments;
+            first_index[p + 1] = first_index[p] + (6 * (segments + joins));
+        }
+
+        const size_t total = first_segment.back();
+        if (total == 0) {
+            return;
+        }
+
+        auto base_index = static_cast<GLuint>(vbo.Size());
+        auto elements = vbo.Extend(total * 4);
+        auto indices = ebo.Extend(first_index.back());
+
+        auto fill = [&](size_t begin, size_t end) {
+            // polyline of the first segment in the range
+            size_t p = static_cast<size_t>(
+                std::upper_bound(first_segment.begin(), first_segment.end(),
+                                 begin) -
+                first_segment.begin() - 1);
+            Source vertex{source};
+            V v0{};
+            V v1{};
+            for (size_t k = begin; k < end; k++) {
+                while (k >= first_segment[p + 1]) {
+                    p++;
+                }
+                const size_t t = k - first_segment[p];
+                // the end of the previous segment starts this one
+                v0 = k == begin || t == 0 ? vertex(starts[p] + t) : v1;
+                v1 = vertex(starts[p] + t + 1);
+
+                const auto direction = v1.position - v0.position;
+                auto *e = &elements[k * 4];
+                e[0] = {.position = v0.position, .velocity = direction,
+                        .color = v0.color, .size = v0.size};
+                e[1] = {.position = v0.position, .velocity = direction,
+                        .color = v0.color, .size = -v0.size};
+                e[2] = {.position = v1.position, .velocity = direction,
+                        .color = v1.color, .size = v1.size};
+                e[3] = {.position = v1.position, .velocity = direction,
+                        .color = v1.color, .size = -v1.size};
+
+                // same indices as AppendSegment
+                const auto base = base_index + static_cast<GLuint>(k * 4);
+                const size_t offset = t == 0 ? 0 : (12 * t) - 6;
+                auto *idx = &indices[first_index[p] + offset];
+                idx[0] = base + 0;
+                idx[1] = base + 2;
+                idx[2] = base + 1;
+                idx[3] = base + 1;
+                idx[4] = base + 2;
+                idx[5] = base + 3;
+                if (t > 0) {
+                    idx[6] = base - 2;
+                    idx[7] = base + 0;
+                    idx[8] = base - 1;
+                    idx[9] = base - 1;
+                    idx[10] = base + 0;
+                    idx[11] = base + 1;
+                }
+            }
+        };
+        constexpr size_t kMinSegmentsPerThread = 16384;
+        ParallelFor(total, kMinSegmentsPerThread, fill);
+    }
+
     void Save() {
         vbo.Save();
         ebo.Save();
@@ -120,11 +261,21 @@ class Buffer {
     auto VBO() -> auto & { return vbo; }
     auto EBO() -> auto & { return ebo; }
 
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        return PrimitiveMemory(vbo, ebo, vaos);
+    }
+
+    [[nodiscard]] auto Generation() const -> uint64_t {
+        return vbo.Generation() + ebo.Generation();
+    }
+
    private:
     std::map<GLuint, VAO> vaos;
     BufferStack<Element, GL_ARRAY_BUFFER> vbo;
     BufferStack<GLuint, GL_ELEMENT_ARRAY_BUFFER> ebo;
     InstanceBuffer &vbo_inst;
+    // storage of the instance buffer the vertex arrays point into
+    uint64_t instance_storage{};
     std::map<GLuint, bool> vao_configured;
 
     void ConfigureVAO(GLuint ctx_id) {
@@ -150,10 +301,12 @@ class Buffer {
 
         vbo_inst.Bind();
         std::size_t vec4_size = sizeof(glm::vec4);
+        std::size_t instance_offset = vbo_inst.Offset() * sizeof(Instance);
         for (int i = 0; i < 4; i++) {
             glVertexAttribPointer(
                 4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
-                (void *)(offsetof(Instance, transform) + (vec4_size * i)));
+                (void *)(instance_offset + offsetof(Instance, transform) +
+                         (vec4_size * i)));
             glEnableVertexAttribArray(4 + i);
             glVertexAttribDivisor(4 + i, 1);
         }
@@ -166,7 +319,11 @@ class Buffer {
     auto Sync() -> bool {
         bool re_vbo = vbo.Sync();
         bool re_ebo = ebo.Sync();
-        bool re_vbo_inst = vbo_inst.Sync();
+        vbo_inst.Sync();
+        // the instance buffer is shared, so it may have been moved by the
+        // sync of another buffer
+        bool re_vbo_inst = vbo_inst.Storage() != instance_storage;
+        instance_storage = vbo_inst.Storage();
         bool reallocated = re_vbo || re_ebo || re_vbo_inst;
         return reallocated;
     }
@@ -0,0 +1,448 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../gl/instance.hpp"
+#include "../memory.hpp"
+#include "../parallel.hpp"
+#include "line.hpp"
+
+namespace glviskit::line {
+
+// Multi-resolution pyramid for polylines.
+// Polylines are read from the segments of the full resolution base buffer,
+// the pyramid only records the first segment of each, and simplified with
+// Douglas-Peucker at geometrically increasing world-space tolerances.
+// Every level lives in its own line buffer; at render time the coarsest level
+// whose tolerance stays under the pixel budget is drawn instead of the base
+// buffer.
+// Polylines appended after a build are simplified on their own and added to
+// the levels, and the levels follow Save and Restore, so a static scene with
+// per frame lines on top only simplifies the new lines.
+class LOD {
+   public:
+    LOD(InstanceBuffer &vbo_inst, Buffer &base)
+        : vbo_inst{vbo_inst}, base{base} {}
+
+    // lines drawn before enabling are not recorded, so the pyramid stays
+    // unused until the next Clear if the base buffer already has lines
+    void SetEnabled(bool enabled, size_t num_levels) {
+        this->enabled = enabled;
+        this->num_levels = num_levels;
+        complete = Segments() == 0;
+        levels.clear();
+        tolerances.clear();
+        starts.clear();
+        Invalidate();
+    }
+
+    [[nodiscard]] auto Enabled() const -> bool { return enabled; }
+
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        MemoryReport report = VectorMemory(starts);
+        for (const auto &level : levels) {
+            report += level->MemoryUsage();
+        }
+        return report;
+    }
+
+    // maximum allowed simplification error in pixels
+    void SetPixelTolerance(float pixels) { pixel_tolerance = pixels; }
+
+    // record the first segment of a polyline appended to the base buffer,
+    // the polyline takes every segment up to the next one
+    void Start(size_t segment) { starts.push_back(segment); }
+
+    // after the base buffer is saved
+    void Save() {
+        restore_segments = Segments();
+        restore_starts = starts.size();
+        // saved with the levels by the next build that gets here
+        levels_saved = false;
+        if (!rebuild && built_segments == Segments()) {
+            SaveLevels();
+        }
+    }
+
+    // after the base buffer is restored
+    void Restore() {
+        starts.resize((std::min)(starts.size(), restore_starts));
+        if (built_segments <= Segments() && built_starts <= starts.size()) {
+            return;
+        }
+        if (levels_saved) {
+            for (auto &level : levels) {
+                level->Restore();
+            }
+            built_segments = Segments();
+            built_starts = starts.size();
+            bounds_min = saved_bounds_min;
+            bounds_max = saved_bounds_max;
+        } else {
+            Invalidate();
+        }
+    }
+
+    void Clear() {
+        starts.clear();
+        complete = true;
+        Invalidate();
+    }
+
+    // pick the buffer to draw for the given camera transform,
+    // rebuilding the pyramid first if new segments were appended
+    auto Select(const glm::mat4 &mvp, const glm::vec2 &screen_size)
+        -> Buffer & {
+        if (!enabled || !complete || starts.empty()) {
+            return base;
+        }
+
+        if (rebuild || built_segments != Segments()) {
+            Build();
+        }
+
+        size_t level = SelectLevel(mvp, screen_size);
+        return level == 0 ? base : *levels[level - 1];
+    }
+
+   private:
+    // finest level tolerance as a fraction of the bounding box diagonal
+    static constexpr float kFinestDivisions = 4096.0F;
+    // tolerance ratio between consecutive levels
+    static constexpr float kLevelFactor = 4.0F;
+    // polylines are split into chunks of this many vertices,
+    // chunk endpoints are always kept so chunks simplify independently
+    static constexpr size_t kChunkSize = 4096;
+
+    InstanceBuffer &vbo_inst;
+    Buffer &base;
+
+    bool enabled{false};
+    bool complete{true};
+    size_t num_levels{0};
+    float pixel_tolerance{0.5F};
+
+    // first base segment of each polyline
+    std::vector<size_t> starts;
+    size_t restore_segments{};
+    size_t restore_starts{};
+
+    // simplified levels, from finest to coarsest
+    std::vector<std::unique_ptr<Buffer>> levels;
+    std::vector<float> tolerances;
+    glm::vec3 bounds_min{0.0F};
+    glm::vec3 bounds_max{0.0F};
+
+    // part of the polylines the levels hold, everything after it is
+    // appended by the next build unless rebuild is set
+    size_t built_segments{0};
+    size_t built_starts{0};
+    bool rebuild{true};
+    // bounding box diagonal the tolerances were derived from
+    float tolerance_diagonal{0.0F};
+
+    // the levels were saved at the restore point
+    bool levels_saved{false};
+    glm::vec3 saved_bounds_min{0.0F};
+    glm::vec3 saved_bounds_max{0.0F};
+
+    void Invalidate() {
+        rebuild = true;
+        levels_saved = false;
+        built_segments = 0;
+        built_starts = 0;
+    }
+
+    void SaveLevels() {
+        for (auto &level : levels) {
+            level->Save();
+        }
+        saved_bounds_min = bounds_min;
+        saved_bounds_max = bounds_max;
+        levels_saved = true;
+    }
+
+    // 4 base elements per segment, the polyline vertices are the start of
+    // the first segment and the end of every segment
+    [[nodiscard]] auto Segments() const -> size_t {
+        return base.VBO().Size() / 4;
+    }
+
+    [[nodiscard]] auto Position(size_t element) const -> const glm::vec3 & {
+        return base.VBO().Elements()[element].position;
+    }
+
+    // first segment of polyline p, the end of all segments past the last
+    [[nodiscard]] auto PolylineBegin(size_t p) const -> size_t {
+        return p < starts.size() ? starts[p] : Segments();
+    }
+
+    // bounding box of the vertices of segments [first, Segments())
+    void ExtendBounds(size_t first, glm::vec3 &lo, glm::vec3 &hi) const {
+        for (size_t k = first; k < Segments(); k++) {
+            for (size_t element : {k * 4, (k * 4) + 2}) {
+                lo = glm::min(lo, Position(element));
+                hi = glm::max(hi, Position(element));
+            }
+        }
+    }
+
+    // whether the segments past the built part form whole new polylines
+    // that still fit the tolerances
+    [[nodiscard]] auto CanAppend() const -> bool {
+        if (rebuild || built_starts >= starts.size() ||
+            starts[built_starts] != built_segments) {
+            return false;
+        }
+        glm::vec3 lo = bounds_min;
+        glm::vec3 hi = bounds_max;
+        ExtendBounds(built_segments, lo, hi);
+        return glm::length(hi - lo) <= tolerance_diagonal * kLevelFactor;
+    }
+
+    void Build() {
+        // level buffers are created lazily since they need a GL context
+        while (levels.size() < num_levels) {
+            levels.push_back(std::make_unique<Buffer>(vbo_inst));
+        }
+
+        if (!CanAppend()) {
+            Invalidate();
+            for (auto &level : levels) {
+                level->Clear();
+            }
+            bounds_min = glm::vec3{(std::numeric_limits<float>::max)()};
+            bounds_max = glm::vec3{std::numeric_limits<float>::lowest()};
+        }
+
+        // bounding box of all recorded vertices
+        ExtendBounds(built_segments, bounds_min, bounds_max);
+
+        // each level is simplified from the previous one, so the error of
+        // a level is bounded by kLevelFactor / (kLevelFactor - 1) times its
+        // own tolerance
+        if (rebuild) {
+            tolerance_diagonal = glm::length(bounds_max - bounds_min);
+            tolerances.resize(num_levels);
+            float tolerance = tolerance_diagonal / kFinestDivisions;
+            for (auto &level_tolerance : tolerances) {
+                level_tolerance = tolerance;
+                tolerance *= kLevelFactor;
+            }
+        }
+
+        // stop at the save point on the way, so Restore can go back to it
+        size_t first = built_starts;
+        if (!levels_saved && restore_starts >= first &&
+            restore_starts <= starts.size() &&
+            PolylineBegin(restore_starts) == restore_segments) {
+            BuildRange(first, restore_starts);
+            SaveLevels();
+            first = restore_starts;
+        }
+        BuildRange(first, starts.size());
+
+        built_segments = Segments();
+        built_starts = starts.size();
+        rebuild = false;
+    }
+
+    // simplify polylines [first, last) and append them to every level,
+    // indices refer to base elements
+    void BuildRange(size_t first, size_t last) {
+        if (first == last) {
+            return;
+        }
+
+        std::vector<uint32_t> indices;
+        indices.reserve(PolylineBegin(last) - starts[first] + last - first);
+        std::vector<size_t> offsets;
+        offsets.reserve(last - first + 1);
+        for (size_t p = first; p < last; p++) {
+            offsets.push_back(indices.size());
+            const size_t begin = starts[p];
+            const size_t end = PolylineBegin(p + 1);
+            indices.push_back(static_cast<uint32_t>(begin * 4));
+            for (size_t k = begin; k < end; k++) {
+                indices.push_back(static_cast<uint32_t>((k * 4) + 2));
+            }
+        }
+        offsets.push_back(indices.size());
+
+        for (size_t l = 0; l < levels.size(); l++) {
+            Simplify(indices, offsets, tolerances[l]);
+            Emit(*levels[l], indices, offsets);
+        }
+    }
+
+    void Simplify(std::vector<uint32_t> &indices, std::vector<size_t> &offsets,
+                  float tolerance) const {
+        struct Task {
+            size_t first;
+            size_t last;
+        };
+
+        // split polylines into independent chunks, the last vertex of each
+        // polyline is marked here and every other chunk marks its first
+        std::vector<uint8_t> keep(indices.size(), 0);
+        std::vector<Task> tasks;
+        for (size_t p = 0; p + 1 < offsets.size(); p++) {
+            size_t begin = offsets[p];
+            size_t end = offsets[p + 1];
+            if (begin == end) {
+                continue;
+            }
+            keep[end - 1] = 1;
+            for (size_t first = begin; first + 1 < end; first += kChunkSize) {
+                tasks.push_back(
+                    {first, (std::min)(first + kChunkSize, end - 1)});
+            }
+        }
+
+        float tolerance2 = tolerance * tolerance;
+        ParallelFor(tasks.size(), 1, [&](size_t begin, size_t end) {
+            std::vector<std::pair<size_t, size_t>> stack;
+            for (size_t t = begin; t < end; t++) {
+                SimplifyRange(indices, keep, tasks[t].first, tasks[t].last,
+                              tolerance2, stack);
+            }
+        });
+
+        // compact kept vertices into the next level
+        std::vector<uint32_t> kept;
+        std::vector<size_t> kept_offsets;
+        kept_offsets.reserve(offsets.size());
+        for (size_t p = 0; p + 1 < offsets.size(); p++) {
+            kept_offsets.push_back(kept.size());
+            for (size_t i = offsets[p]; i < offsets[p + 1]; i++) {
+                if (keep[i] != 0) {
+                    kept.push_back(indices[i]);
+                }
+            }
+        }
+        kept_offsets.push_back(kept.size());
+
+        indices = std::move(kept);
+        offsets = std::move(kept_offsets);
+    }
+
+    // iterative Douglas-Peucker over indices[first..last]
+    void SimplifyRange(const std::vector<uint32_t> &indices,
+                       std::vector<uint8_t> &keep, size_t first, size_t last,
+                       float tolerance2,
+                       std::vector<std::pair<size_t, size_t>> &stack) const {
+        keep[first] = 1;
+        stack.clear();
+        stack.emplace_back(first, last);
+
+        while (!stack.empty()) {
+            auto [f, l] = stack.back();
+            stack.pop_back();
+            if (l - f < 2) {
+                continue;
+            }
+
+            const glm::vec3 a = Position(indices[f]);
+            const glm::vec3 ab = Position(indices[l]) - a;
+            const float ab2 = glm::dot(ab, ab);
+
+            float max_dist2 = 0.0F;
+            size_t max_index = f;
+            for (size_t i = f + 1; i < l; i++) {
+                const glm::vec3 ap = Position(indices[i]) - a;
+                // distance to the segment, clamping the projection
+                float t = ab2 > 0.0F
+                              ? glm::clamp(glm::dot(ap, ab) / ab2, 0.0F, 1.0F)
+                              : 0.0F;
+                const glm::vec3 d = ap - (ab * t);
+                float dist2 = glm::dot(d, d);
+                if (dist2 > max_dist2) {
+                    max_dist2 = dist2;
+                    max_index = i;
+                }
+            }
+
+            if (max_dist2 > tolerance2) {
+                keep[max_index] = 1;
+                stack.emplace_back(f, max_index);
+                stack.emplace_back(max_index, l);
+            }
+        }
+    }
+
+    void Emit(Buffer &buffer, const std::vector<uint32_t> &indices,
+              const std::vector<size_t> &offsets) const {
+        const auto elements = base.VBO().Elements();
+        for (size_t p = 0; p + 1 < offsets.size(); p++) {
+            size_t begin = offsets[p];
+            for (size_t k = begin + 1; k < offsets[p + 1]; k++) {
+                const auto &v0 = elements[indices[k - 1]];
+                const auto &v1 = elements[indices[k]];
+                buffer.AppendSegment(v0.position, v0.color, v0.size,
+                                     v1.position, v1.color, v1.size,
+                                     k > begin + 1);
+            }
+        }
+    }
+
+    auto SelectLevel(const glm::mat4 &mvp, const glm::vec2 &screen_size) const
+        -> size_t {
+        float diagonal = glm::length(bounds_max - bounds_min);
+        size_t level = levels.size();
+        if (diagonal <= 0.0F) {
+            return level;
+        }
+
+        // the finest level required by any instance wins
+        for (const auto &instance : vbo_inst.Elements()) {
+            float pixels =
+                ProjectedDiagonal(mvp * instance.transform, screen_size);
+            if (pixels <= 0.0F) {
+                // partially behind the camera, keep full resolution
+                return 0;
+            }
+
+            float budget = pixel_tolerance * diagonal / pixels;
+            size_t allowed = 0;
+            while (allowed < tolerances.size() &&
+                   tolerances[allowed] <= budget) {
+                allowed++;
+            }
+            level = (std::min)(level, allowed);
+        }
+        return level;
+    }
+
+    // screen space diagonal of the bounding box in pixels,
+    // or a negative value if any corner is behind the camera
+    [[nodiscard]] auto ProjectedDiagonal(const glm::mat4 &transform,
+                                         const glm::vec2 &screen_size) const
+        -> float {
+        glm::vec2 lo{(std::numeric_limits<float>::max)()};
+        glm::vec2 hi{std::numeric_limits<float>::lowest()};
+        for (int i = 0; i < 8; i++) {
+            glm::vec4 corner{(i & 1) != 0 ? bounds_max.x : bounds_min.x,
+                             (i & 2) != 0 ? bounds_max.y : bounds_min.y,
+                             (i & 4) != 0 ? bounds_max.z : bounds_min.z, 1.0F};
+            glm::vec4 clip = transform * corner;
+            if (clip.w <= 1e-6F) {
+                return -1.0F;
+            }
+            glm::vec2 pixel =
+                glm::vec2{clip.x / clip.w, clip.y / clip.w} * screen_size *
+                0.5F;
+            lo = glm::min(lo, pixel);
+            hi = glm::max(hi, pixel);
+        }
+        return glm::length(hi - lo);
+    }
+};
+
+}  // namespace glviskit::line
@@ -1,14 +1,19 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <map>
 
 #include "../gl/buffer_stack.hpp"
+#include "../gl/counters.hpp"
 #include "../gl/gl.hpp"
 #include "../gl/instance.hpp"
+#include "../gl/oit.hpp"
 #include "../gl/program.hpp"
 #include "../gl/vao.hpp"
+#include "../memory.hpp"
+#include "../profiler.hpp"
 
 namespace glviskit::point {
 
@@ -45,10 +50,24 @@ inline constexpr char shader_fragment[] = GLVISKIT_FRAG_HEADER R"glsl(
     }
 )glsl";
 
+// Variant of the fragment shader for weighted blended transparency,
+// it writes to the accumulation targets described in gl/oit.hpp
+// NOLINTNEXTLINE(hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+inline constexpr char shader_fragment_oit[] =
+    GLVISKIT_FRAG_HEADER GLVISKIT_OIT_FRAG_OUTPUT R"glsl(
+    in vec4 v_color;
+
+    void main() {
+        oit_output(v_color);
+    }
+)glsl";
+
 // Define PointProgram which holds the shaders.
 // In theory, multiple point programs with different shaders could be defined
 // for same PointBuffer.
 // NOLINTNEXTLINE(hicpp-no-array-decay)
+using ProgramOIT = glviskit::Program<shader_vertex, shader_fragment_oit>;
+// NOLINTNEXTLINE(hicpp-no-array-decay)
 using Program = Program<shader_vertex, shader_fragment>;
 
 // PointBuffer is responsible for storing and rendering points
@@ -86,18 +105,18 @@ class Buffer {
 
         // configure VAO if not yet configured
         if (!vao_configured.at(ctx_id)) {
+            ScopedTimer timer{Profiler::Stage::ConfigureVAO};
             ConfigureVAO(ctx_id);
             vao_configured.at(ctx_id) = true;
         }
 
         // bind VAO using RAII binder,
         // which will unbind it at the end of the scope
+        ScopedTimer timer{Profiler::Stage::Draw};
         auto &vao = vaos.at(ctx_id);
         vao.Bind();
         // draw call
-        glDrawElementsInstanced(GL_POINTS, static_cast<GLsizei>(ebo.Size()),
-                                GL_UNSIGNED_INT, nullptr,
-                                static_cast<GLsizei>(vbo_inst.Size()));
+        DrawElementsInstanced(GL_POINTS, vbo, ebo, vbo_inst);
         vao.Unbind();
     }
 
@@ -119,6 +138,14 @@ class Buffer {
     auto VBO() -> auto & { return vbo; }
     auto EBO() -> auto & { return ebo; }
 
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        return PrimitiveMemory(vbo, ebo, vaos);
+    }
+
+    [[nodiscard]] auto Generation() const -> uint64_t {
+        return vbo.Generation() + ebo.Generation();
+    }
+
    private:
     std::map<GLuint, bool> vao_configured;
     // In this case, we don't really need an EBO
@@ -131,6 +158,8 @@ class Buffer {
     // note that this is a reference since we are generally
     // sharing it with other primitive buffer classes
     InstanceBuffer &vbo_inst;
+    // storage of the instance buffer the vertex arrays point into
+    uint64_t instance_storage{};
 
     void ConfigureVAO(GLuint ctx_id) {
         VAO &vao = vaos.at(ctx_id);
@@ -153,10 +182,12 @@ class Buffer {
 
         // attribute for transform matrix used in instancing
         vbo_inst.Bind();
+        const size_t instance_offset = vbo_inst.Offset() * sizeof(Instance);
         for (int i = 0; i < 4; i++) {
             glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE,
                                   sizeof(Instance),
-                                  (void *)(offsetof(Instance, transform) +
+                                  (void *)(instance_offset +
+                                           offsetof(Instance, transform) +
                                            (sizeof(glm::vec4) * i)));
             glEnableVertexAttribArray(3 + i);
             // set attribute divisor for instancing
@@ -172,7 +203,11 @@ class Buffer {
         // sync all buffers
         bool re_vbo = vbo.Sync();
         bool re_ebo = ebo.Sync();
-        bool re_vbo_inst = vbo_inst.Sync();
+        vbo_inst.Sync();
+        // the instance buffer is shared, so it may have been moved by the
+        // sync of another buffer
+        bool re_vbo_inst = vbo_inst.Storage() != instance_storage;
+        instance_storage = vbo_inst.Storage();
         bool reallocated = re_vbo || re_ebo || re_vbo_inst;
         return reallocated;
     }
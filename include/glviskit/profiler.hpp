@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace glviskit {
+
+// Percentiles over the frames kept by the profiler.
+struct ProfileSummary {
+    double mean{0.0};
+    double p50{0.0};
+    double p95{0.0};
+    double p99{0.0};
+    double max{0.0};
+};
+
+// CPU time per pipeline stage in milliseconds, upload sizes in bytes.
+struct ProfileReport {
+    ProfileSummary events;
+    ProfileSummary sync;
+    ProfileSummary configure_vao;
+    ProfileSummary draw;
+    ProfileSummary swap;
+    ProfileSummary frame;
+    ProfileSummary upload_bytes;
+    // frames currently kept and frames recorded in total
+    uint64_t frames{0};
+    uint64_t total_frames{0};
+    // frames that took much longer than the median, kept and in total
+    uint64_t stutters{0};
+    uint64_t total_stutters{0};
+};
+
+// Per frame CPU stage profiler of the render loop.
+// Stages are timed with ScopedTimer, times of a stage are summed over the
+// frame and kept in a fixed ring of the last kFrames frames. Disabled by
+// default, in which case timers do not even read the clock.
+// Only meant to be used from the thread running the render loop.
+class Profiler {
+   public:
+    enum class Stage : uint8_t {
+        Events,
+        Sync,
+        ConfigureVAO,
+        Draw,
+        Swap,
+        Count,
+    };
+
+    static constexpr size_t kFrames = 240;
+
+    // singleton access
+    static auto GetInstance() -> Profiler & {
+        static Profiler instance;
+        return instance;
+    }
+
+    Profiler(const Profiler &) = delete;
+    auto operator=(const Profiler &) -> Profiler & = delete;
+    Profiler(Profiler &&) = delete;
+    auto operator=(Profiler &&) -> Profiler & = delete;
+    ~Profiler() = default;
+
+    void SetEnabled(bool enabled) {
+        this->enabled = enabled;
+        in_frame = false;
+    }
+    [[nodiscard]] auto Enabled() const -> bool { return enabled; }
+
+    void BeginFrame() {
+        if (!enabled) {
+            return;
+        }
+        current = Frame{};
+        frame_start = Clock::now();
+        in_frame = true;
+    }
+
+    // finish the frame started by BeginFrame, frames without rendering
+    // are dropped so idle waiting does not count as frame time
+    void EndFrame(bool rendered) {
+        if (!enabled || !in_frame) {
+            return;
+        }
+        in_frame = false;
+        if (!rendered) {
+            return;
+        }
+
+        current.frame_ms = Milliseconds(Clock::now() - frame_start);
+
+        // compare against the median of the frames before this one
+        if (count >= kMinStutterFrames) {
+            for (size_t i = 0; i < count; i++) {
+                frame_times[i] = frames[i].frame_ms;
+            }
+            const double median =
+                Percentile(std::span{frame_times.data(), count}, 0.5);
+            current.stutter = current.frame_ms > kStutterFactor * median;
+        }
+        if (current.stutter) {
+            total_stutters++;
+        }
+
+        frames[next] = current;
+        next = (next + 1) % kFrames;
+        count = (std::min)(count + 1, kFrames);
+        total_frames++;
+    }
+
+    void Add(Stage stage, double ms) {
+        if (in_frame) {
+            current.stage_ms[static_cast<size_t>(stage)] += ms;
+        }
+    }
+
+    void AddUploadBytes(size_t bytes) {
+        if (in_frame) {
+            current.upload_bytes += bytes;
+        }
+    }
+
+    [[nodiscard]] auto Report() const -> ProfileReport {
+        ProfileReport report;
+        report.events = Summarize([](const Frame &f) {
+            return f.stage_ms[static_cast<size_t>(Stage::Events)];
+        });
+        report.sync = Summarize([](const Frame &f) {
+            return f.stage_ms[static_cast<size_t>(Stage::Sync)];
+        });
+        report.configure_vao = Summarize([](const Frame &f) {
+            return f.stage_ms[static_cast<size_t>(Stage::ConfigureVAO)];
+        });
+        report.draw = Summarize([](const Frame &f) {
+            return f.stage_ms[static_cast<size_t>(Stage::Draw)];
+        });
+        report.swap = Summarize([](const Frame &f) {
+            return f.stage_ms[static_cast<size_t>(Stage::Swap)];
+        });
+        report.frame = Summarize([](const Frame &f) { return f.frame_ms; });
+        report.upload_bytes = Summarize([](const Frame &f) {
+            return static_cast<double>(f.upload_bytes);
+        });
+
+        report.frames = count;
+        report.total_frames = total_frames;
+        for (size_t i = 0; i < count; i++) {
+            report.stutters += frames[i].stutter ? 1 : 0;
+        }
+        report.total_stutters = total_stutters;
+        return report;
+    }
+
+    void Clear() {
+        count = 0;
+        next = 0;
+        total_frames = 0;
+        total_stutters = 0;
+        in_frame = false;
+    }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    // a frame is a stutter if it took this many times the median
+    static constexpr double kStutterFactor = 2.0;
+    // frames needed before a median is trusted
+    static constexpr size_t kMinStutterFrames = 30;
+
+    struct Frame {
+        std::array<double, static_cast<size_t>(Stage::Count)> stage_ms{};
+        double frame_ms{0.0};
+        size_t upload_bytes{0};
+        bool stutter{false};
+    };
+
+    bool enabled{false};
+    bool in_frame{false};
+    Clock::time_point frame_start;
+    Frame current;
+
+    std::array<Frame, kFrames> frames{};
+    size_t next{0};
+    size_t count{0};
+    uint64_t total_frames{0};
+    uint64_t total_stutters{0};
+    // scratch for the median frame time, so EndFrame does not allocate
+    std::array<double, kFrames> frame_times{};
+
+    Profiler() = default;
+
+    template <typename D>
+    static auto Milliseconds(D duration) -> double {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    // nearest rank percentile, reorders values
+    static auto Percentile(std::span<double> values, double p) -> double {
+        auto size = static_cast<double>(values.size());
+        auto rank = (std::min)(static_cast<size_t>(p * size), values.size() - 1);
+        std::nth_element(values.begin(),
+                         values.begin() + static_cast<ptrdiff_t>(rank),
+                         values.end());
+        return values[rank];
+    }
+
+    template <typename F>
+    [[nodiscard]] auto Summarize(F &&value) const -> ProfileSummary {
+        ProfileSummary summary;
+        if (count == 0) {
+            return summary;
+        }
+
+        std::vector<double> values(count);
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            values[i] = value(frames[i]);
+            sum += values[i];
+        }
+        summary.mean = sum / static_cast<double>(count);
+        summary.max = *std::max_element(values.begin(), values.end());
+        summary.p50 = Percentile(values, 0.5);
+        summary.p95 = Percentile(values, 0.95);
+        summary.p99 = Percentile(values, 0.99);
+        return summary;
+    }
+
+    friend class ScopedTimer;
+};
+
+// Adds the time until the end of the scope to a profiler stage.
+class ScopedTimer {
+   public:
+    explicit ScopedTimer(Profiler::Stage stage)
+        : profiler{Profiler::GetInstance()},
+          stage{stage},
+          active{profiler.in_frame} {
+        if (active) {
+            start = Profiler::Clock::now();
+        }
+    }
+
+    ~ScopedTimer() {
+        if (active) {
+            profiler.Add(stage, Profiler::Milliseconds(
+                                    Profiler::Clock::now() - start));
+        }
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    auto operator=(const ScopedTimer &) -> ScopedTimer & = delete;
+    ScopedTimer(ScopedTimer &&) = delete;
+    auto operator=(ScopedTimer &&) -> ScopedTimer & = delete;
+
+   private:
+    Profiler &profiler;
+    Profiler::Stage stage;
+    bool active;
+    Profiler::Clock::time_point start;
+};
+
+}  // namespace glviskit
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "gl/gl.hpp"
+#include "primitive/circle.hpp"
+#include "primitive/line.hpp"
+#include "primitive/point.hpp"
+
+namespace glviskit {
+
+// Drawing calls of RenderBuffer recorded into plain vectors, with their own
+// current color, size and line state. Recorders make no GL calls and share
+// nothing, so every thread can fill its own while others do the same, then
+// RenderBuffer::Merge appends any number of them in one pass.
+// Indices are local to the recorder and rebased by the merge.
+class Recorder {
+   public:
+    void Line(glm::vec3 start, glm::vec3 end) { Line(start, end, color, size); }
+
+    void Line(glm::vec3 start, glm::vec3 end, const glm::vec4 &c, float s) {
+        LineEnd();
+        LineTo(start, c, s);
+        LineTo(end, c, s);
+        LineEnd();
+    }
+
+    void Point(glm::vec3 position) { Point(position, color, size); }
+
+    void Point(glm::vec3 position, const glm::vec4 &c, float s) {
+        points.ebo.Append(static_cast<GLuint>(points.vbo.Size()));
+        points.vbo.Append({.position = position, .color = c, .size = s});
+    }
+
+    void LineTo(glm::vec3 position) { LineTo(position, color, size); }
+
+    void LineTo(glm::vec3 position, const glm::vec4 &c, float s) {
+        if (line_counter == 1) {
+            // the first segment of a polyline, for the level of detail
+            // pyramid of the merge target
+            line_starts.push_back(lines.vbo.Size() / 4);
+        }
+        if (line_counter > 0) {
+            line::Buffer::AppendSegment(lines.vbo, lines.ebo, line_prev,
+                                        color_prev, size_prev, position, c, s,
+                                        line_counter > 1);
+        }
+        line_prev = position;
+        color_prev = c;
+        size_prev = s;
+        line_counter++;
+    }
+
+    void LineEnd() { line_counter = 0; }
+
+    void Circle(glm::vec3 circle) { Circle(circle, color, size); }
+
+    void Circle(glm::vec3 circle, const glm::vec4 &c, float s) {
+        circle::Buffer::AppendCircle(circles.vbo, circles.ebo, circle, c, s);
+    }
+
+    // attributes for subsequent drawing
+    void Color(const glm::vec4 &c) { color = c; }
+    void Size(float s) { size = s; }
+    [[nodiscard]] auto GetColor() const -> const glm::vec4 & { return color; }
+    [[nodiscard]] auto GetSize() const -> float { return size; }
+
+    // forget the recorded geometry but keep the memory for the next frame,
+    // the attributes stay
+    void Clear() {
+        points.Clear();
+        circles.Clear();
+        lines.Clear();
+        line_starts.clear();
+        line_counter = 0;
+    }
+
+    [[nodiscard]] auto Empty() const -> bool {
+        return points.vbo.Size() == 0 && circles.vbo.Size() == 0 &&
+               lines.vbo.Size() == 0;
+    }
+
+   private:
+    // vector with the appending interface of BufferStack
+    template <typename T>
+    struct Scratch {
+        std::vector<T> elements;
+
+        void Append(const T &element) { elements.push_back(element); }
+        [[nodiscard]] auto Size() const -> size_t { return elements.size(); }
+    };
+
+    template <typename T>
+    struct Geometry {
+        Scratch<T> vbo;
+        Scratch<GLuint> ebo;
+
+        void Clear() {
+            vbo.elements.clear();
+            ebo.elements.clear();
+        }
+    };
+
+    Geometry<point::Buffer::Element> points;
+    Geometry<circle::Buffer::Element> circles;
+    Geometry<line::Buffer::Element> lines;
+    // first segment of every polyline, 4 line elements each
+    std::vector<size_t> line_starts;
+
+    // attributes for recording
+    glm::vec4 color{1.0F};
+    float size = 1.0F;
+
+    // line drawing state
+    size_t line_counter = 0;
+    glm::vec3 line_prev{0.0F};
+    glm::vec4 color_prev{1.0F};
+    float size_prev = 1.0F;
+
+    friend class RenderBuffer;
+};
+
+}  // namespace glviskit
@@ -1,103 +1,94 @@
 #pragma once
 
-#include <glm/ext/matrix_transform.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <glm/geometric.hpp>
 #include <glm/glm.hpp>
+#include <span>
+#include <stdexcept>
+#include <vector>
 
 #include "gl/buffer_stack.hpp"
 #include "gl/instance.hpp"
+#include "memory.hpp"
+#include "parallel.hpp"
 #include "primitive/circle.hpp"
 #include "primitive/line.hpp"
+#include "primitive/line_lod.hpp"
 #include "primitive/point.hpp"
+#include "recorder.hpp"
+#include "transform.hpp"
 
 namespace glviskit {
 
+// vertex with its attributes for the bulk drawing calls of RenderBuffer
+struct Vertex {
+    glm::vec3 position;
+    glm::vec4 color;
+    float size;
+};
+
 class RenderBuffer {
    public:
     RenderBuffer()
         : line_buffer{vbo_inst},
           point_buffer{vbo_inst},
-          circle_buffer{vbo_inst} {
+          circle_buffer{vbo_inst},
+          line_lod{vbo_inst, line_buffer} {
         // create identity instance
         AddInstance(glm::mat4{1.0F});
     }
 
-    void Line(glm::vec3 start, glm::vec3 end) {
+    void Line(glm::vec3 start, glm::vec3 end) { Line(start, end, color, size); }
+
+    // overloads taking a color and size draw with them instead of the
+    // current attributes, without changing those
+    void Line(glm::vec3 start, glm::vec3 end, const glm::vec4 &c, float s) {
         // if there is an ongoing line, end it first
         // otherwise, this is noop
         LineEnd();
-        LineTo(start);
-        LineTo(end);
+        LineTo(start, c, s);
+        LineTo(end, c, s);
         LineEnd();
     }
 
-    void Point(glm::vec3 position) {
+    void Point(glm::vec3 position) { Point(position, color, size); }
+
+    void Point(glm::vec3 position, const glm::vec4 &c, float s) {
         auto &vbo = point_buffer.VBO();
         auto &ebo = point_buffer.EBO();
 
         size_t index = vbo.Size();
-        vbo.Append({.position = position, .color = color, .size = size});
+        vbo.Append({.position = position, .color = c, .size = s});
         ebo.Append(index);
     }
 
     // Efficient way to draw connected lines
-    void LineTo(glm::vec3 position) {
-        auto &vbo = line_buffer.VBO();
-        auto &ebo = line_buffer.EBO();
-
-        size_t base_index = vbo.Size();
+    void LineTo(glm::vec3 position) { LineTo(position, color, size); }
 
+    void LineTo(glm::vec3 position, const glm::vec4 &c, float s) {
         if (line_counter == 0) {
             // for first point just store and return
             line_prev = position;
-            color_prev = color;
-            size_prev = size;
+            color_prev = c;
+            size_prev = s;
             line_counter++;
             return;
         }
 
-        auto direction = position - line_prev;
-        // vertices for new line segment
-        vbo.Append({.position = line_prev,
-                    .velocity = direction,
-                    .color = color_prev,
-                    .size = size_prev});
-        vbo.Append({.position = line_prev,
-                    .velocity = direction,
-                    .color = color_prev,
-                    .size = -size_prev});
-        vbo.Append({.position = position,
-                    .velocity = direction,
-                    .color = color,
-                    .size = size});
-        vbo.Append({.position = position,
-                    .velocity = direction,
-                    .color = color,
-                    .size = -size});
-
-        // new line segment
-        ebo.Append(base_index + 0);
-        ebo.Append(base_index + 2);
-        ebo.Append(base_index + 1);
-        ebo.Append(base_index + 1);
-        ebo.Append(base_index + 2);
-        ebo.Append(base_index + 3);
-
-        if (line_counter > 1) {
-            // connect previous segment
-            // we have +0, +1 from new segment and -2, -1 from previous segment
-            ebo.Append(base_index - 2);
-            ebo.Append(base_index + 0);
-            ebo.Append(base_index - 1);
-            ebo.Append(base_index - 1);
-            ebo.Append(base_index + 0);
-            ebo.Append(base_index + 1);
+        if (line_counter == 1 && line_lod.Enabled()) {
+            line_lod.Start(line_buffer.VBO().Size() / 4);
         }
 
+        // new line segment, connected to the previous one if any
+        line_buffer.AppendSegment(line_prev, color_prev, size_prev, position,
+                                  c, s, line_counter > 1);
+
         // update previous points
         line_prev = position;
-        color_prev = color;
-        size_prev = size;
+        color_prev = c;
+        size_prev = s;
         line_counter++;
     }
 
@@ -106,28 +97,142 @@ class RenderBuffer {
         line_counter = 0;
     }
 
-    void Circle(glm::vec3 circle) {
+    void Circle(glm::vec3 circle) { Circle(circle, color, size); }
+
+    void Circle(glm::vec3 circle, const glm::vec4 &c, float s) {
+        circle::Buffer::AppendCircle(circle_buffer.VBO(), circle_buffer.EBO(),
+                                     circle, c, s);
+    }
+
+    // bulk versions of Point, Circle and LineTo, each vertex has its own
+    // attributes and the buffers grow once per call
+    void Points(std::span<const Vertex> vertices) {
+        auto &vbo = point_buffer.VBO();
+        auto &ebo = point_buffer.EBO();
+
+        auto index = static_cast<GLuint>(vbo.Size());
+        auto elements = vbo.Extend(vertices.size());
+        auto indices = ebo.Extend(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const auto &v = vertices[i];
+            elements[i] = {.position = v.position, .color = v.color,
+                           .size = v.size};
+            indices[i] = index + static_cast<GLuint>(i);
+        }
+    }
+
+    void Circles(std::span<const Vertex> vertices) {
         auto &vbo = circle_buffer.VBO();
         auto &ebo = circle_buffer.EBO();
-        size_t index = vbo.Size();
-        auto s = size;
-        // four vertices
-        vbo.Append({.circle = circle, .position = {-s, -s, 0}, .color = color});
-        vbo.Append({.circle = circle, .position = {s, -s, 0}, .color = color});
-        vbo.Append({.circle = circle, .position = {s, s, 0}, .color = color});
-        vbo.Append({.circle = circle, .position = {-s, s, 0}, .color = color});
-        // two triangles
-        ebo.Append(index + 0);
-        ebo.Append(index + 1);
-        ebo.Append(index + 2);
-        ebo.Append(index + 2);
-        ebo.Append(index + 3);
-        ebo.Append(index + 0);
+
+        auto index = static_cast<GLuint>(vbo.Size());
+        auto elements = vbo.Extend(vertices.size() * 4);
+        auto indices = ebo.Extend(vertices.size() * 6);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const auto &[center, c, s] = vertices[i];
+            auto *e = &elements[i * 4];
+            e[0] = {.circle = center, .position = {-s, -s, 0}, .color = c};
+            e[1] = {.circle = center, .position = {s, -s, 0}, .color = c};
+            e[2] = {.circle = center, .position = {s, s, 0}, .color = c};
+            e[3] = {.circle = center, .position = {-s, s, 0}, .color = c};
+
+            auto base = index + static_cast<GLuint>(i * 4);
+            auto *t = &indices[i * 6];
+            t[0] = base + 0;
+            t[1] = base + 1;
+            t[2] = base + 2;
+            t[3] = base + 2;
+            t[4] = base + 3;
+            t[5] = base + 0;
+        }
+    }
+
+    void LinesTo(std::span<const Vertex> vertices) {
+        for (const auto &v : vertices) {
+            LineTo(v.position, v.color, v.size);
+        }
+    }
+
+    // polylines [starts[p], ends[p]) of the vertices returned by source(i),
+    // copies of source read them on several threads, see
+    // line::Buffer::AppendPolylines, ends an ongoing LineTo polyline first
+    template <typename Source>
+    void Polylines(const Source &source, std::span<const size_t> starts,
+                   std::span<const size_t> ends) {
+        LineEnd();
+        if (line_lod.Enabled()) {
+            size_t segment = line_buffer.VBO().Size() / 4;
+            for (size_t p = 0; p < starts.size(); p++) {
+                if (ends[p] > starts[p] + 1) {
+                    line_lod.Start(segment);
+                    segment += ends[p] - starts[p] - 1;
+                }
+            }
+        }
+        line_buffer.AppendPolylines(source, starts, ends);
+    }
+
+    // polylines from starts[p] up to the next start or the end of vertices,
+    // starts must not decrease
+    void Polylines(std::span<const Vertex> vertices,
+                   std::span<const size_t> starts) {
+        std::vector<size_t> ends(starts.size());
+        for (size_t p = 0; p < starts.size(); p++) {
+            ends[p] = p + 1 < starts.size() ? starts[p + 1] : vertices.size();
+        }
+        Polylines([vertices](size_t i) { return vertices[i]; }, starts, ends);
+    }
+
+    // separate lines between consecutive pairs of vertices
+    void Lines(std::span<const Vertex> vertices) {
+        for (size_t i = 0; i + 1 < vertices.size(); i += 2) {
+            const auto &start = vertices[i];
+            const auto &end = vertices[i + 1];
+            LineEnd();
+            LineTo(start.position, start.color, start.size);
+            LineTo(end.position, end.color, end.size);
+            LineEnd();
+        }
+    }
+
+    // Append everything the recorders recorded, in their order, and end an
+    // ongoing LineTo polyline first. Each buffer grows once, the recorders
+    // are copied into their places with rebased indices in parallel. The
+    // recorders are left as they are, and must not be recorded into
+    // meanwhile.
+    void Merge(std::span<const Recorder *const> recorders) {
+        LineEnd();
+        if (line_lod.Enabled()) {
+            size_t segment = line_buffer.VBO().Size() / 4;
+            for (const auto *recorder : recorders) {
+                for (size_t start : recorder->line_starts) {
+                    line_lod.Start(segment + start);
+                }
+                segment += recorder->lines.vbo.Size() / 4;
+            }
+        }
+        MergeGeometry(point_buffer, recorders, &Recorder::points);
+        MergeGeometry(circle_buffer, recorders, &Recorder::circles);
+        MergeGeometry(line_buffer, recorders, &Recorder::lines);
     }
 
     // attributes for subsequent drawing
     void Color(const glm::vec4 &c) { color = c; }
     void Size(float s) { size = s; }
+    [[nodiscard]] auto GetColor() const -> const glm::vec4 & { return color; }
+    [[nodiscard]] auto GetSize() const -> float { return size; }
+
+    // level of detail pyramid for polylines, enable before drawing lines
+    void SetLineLOD(bool enabled, size_t levels = 6) {
+        line_lod.SetEnabled(enabled, levels);
+        settings_generation++;
+    }
+
+    // maximum on-screen simplification error in pixels
+    void SetLineLODTolerance(float pixels) {
+        line_lod.SetPixelTolerance(pixels);
+        settings_generation++;
+    }
 
     // instancing
     void AddInstance(const glm::mat4 &transform) {
@@ -137,20 +242,46 @@ class RenderBuffer {
     void AddInstance(const glm::vec3 &position,
                      const glm::vec3 &rotation = glm::vec3{0.0F},
                      const glm::vec3 &scale = glm::vec3{1.0F}) {
-        // translation
-        auto t = glm::translate(glm::mat4{1.0F}, position);
-
-        // rotation
-        auto angle = glm::length(rotation);
-        glm::mat4 r{1.0F};
-        if (angle > 1e-6F) {
-            auto axis = rotation / angle;
-            r = glm::rotate(glm::mat4{1.0F}, angle, axis);
+        AddInstance(ComposeTransform(position, rotation, scale));
+    }
+
+    void AddInstances(std::span<const glm::mat4> transforms) {
+        auto out = vbo_inst.Extend(transforms.size());
+        for (size_t i = 0; i < transforms.size(); i++) {
+            out[i].transform = transforms[i];
+        }
+    }
+
+    // empty rotations and scales default to zero and one, otherwise all
+    // spans have one element per instance
+    void AddInstances(std::span<const glm::vec3> positions,
+                      std::span<const glm::vec3> rotations = {},
+                      std::span<const glm::vec3> scales = {}) {
+        CheckInstanceSpans(positions, rotations, scales);
+        ComposeInstances(vbo_inst.Extend(positions.size()), positions,
+                         rotations, scales);
+    }
+
+    // overwrite the instances from first on in place, e.g. to animate them
+    // every frame without clearing and appending
+    void SetInstances(size_t first, std::span<const glm::mat4> transforms) {
+        auto out = OverwriteInstances(first, transforms.size());
+        for (size_t i = 0; i < transforms.size(); i++) {
+            out[i].transform = transforms[i];
         }
+    }
+
+    void SetInstances(size_t first, std::span<const glm::vec3> positions,
+                      std::span<const glm::vec3> rotations = {},
+                      std::span<const glm::vec3> scales = {}) {
+        CheckInstanceSpans(positions, rotations, scales);
+        ComposeInstances(OverwriteInstances(first, positions.size()),
+                         positions, rotations, scales);
+    }
 
-        // scale
-        auto s = glm::scale(glm::mat4{1.0F}, scale);
-        AddInstance(t * r * s);
+    // including the identity instance every render buffer starts with
+    [[nodiscard]] auto InstanceCount() const -> size_t {
+        return vbo_inst.Size();
     }
 
     // save and restore buffers
@@ -158,18 +289,50 @@ class RenderBuffer {
         line_buffer.Save();
         point_buffer.Save();
         circle_buffer.Save();
+        line_lod.Save();
     }
 
     void Restore() {
         line_buffer.Restore();
         point_buffer.Restore();
         circle_buffer.Restore();
+        line_lod.Restore();
     }
 
     void Clear() {
         line_buffer.Clear();
         point_buffer.Clear();
         circle_buffer.Clear();
+        line_lod.Clear();
+    }
+
+    // incremented whenever anything that is rendered changes,
+    // used to skip redrawing unchanged windows
+    [[nodiscard]] auto Generation() const -> uint64_t {
+        return line_buffer.Generation() + point_buffer.Generation() +
+               circle_buffer.Generation() + vbo_inst.Generation() +
+               settings_generation;
+    }
+
+    [[nodiscard]] auto MemoryBreakdown() const -> RenderBufferMemory {
+        RenderBufferMemory memory;
+        memory.lines = line_buffer.MemoryUsage();
+        memory.points = point_buffer.MemoryUsage();
+        memory.circles = circle_buffer.MemoryUsage();
+        memory.instances = vbo_inst.MemoryUsage();
+        memory.line_lod = line_lod.MemoryUsage();
+
+        memory.total.render_buffers = 1;
+        memory.total += memory.lines;
+        memory.total += memory.points;
+        memory.total += memory.circles;
+        memory.total += memory.instances;
+        memory.total += memory.line_lod;
+        return memory;
+    }
+
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        return MemoryBreakdown().total;
     }
 
     void SaveInstances() { vbo_inst.Save(); }
@@ -182,21 +345,111 @@ class RenderBuffer {
     // instance transform buffer
     InstanceBuffer vbo_inst;
 
+    auto OverwriteInstances(size_t first, size_t count)
+        -> std::span<Instance> {
+        if (first > vbo_inst.Size() || count > vbo_inst.Size() - first) {
+            throw std::out_of_range("instance range past the last instance");
+        }
+        return vbo_inst.Overwrite(first, count);
+    }
+
+    static void CheckInstanceSpans(std::span<const glm::vec3> positions,
+                                   std::span<const glm::vec3> rotations,
+                                   std::span<const glm::vec3> scales) {
+        if ((!rotations.empty() && rotations.size() != positions.size()) ||
+            (!scales.empty() && scales.size() != positions.size())) {
+            throw std::invalid_argument(
+                "rotations and scales must be empty or match positions");
+        }
+    }
+
+    static void ComposeInstances(std::span<Instance> out,
+                                 std::span<const glm::vec3> positions,
+                                 std::span<const glm::vec3> rotations,
+                                 std::span<const glm::vec3> scales) {
+        constexpr size_t kMinInstancesPerThread = 8192;
+        ParallelFor(out.size(), kMinInstancesPerThread,
+                    [&](size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; i++) {
+                            out[i].transform = ComposeTransform(
+                                positions[i],
+                                rotations.empty() ? glm::vec3{0.0F}
+                                                  : rotations[i],
+                                scales.empty() ? glm::vec3{1.0F} : scales[i]);
+                        }
+                    });
+    }
+
+    template <typename Buffer, typename G>
+    static void MergeGeometry(Buffer &buffer,
+                              std::span<const Recorder *const> recorders,
+                              G Recorder::*geometry) {
+        // first element and index of every recorder, totals at the end
+        std::vector<size_t> first_element(recorders.size() + 1, 0);
+        std::vector<size_t> first_index(recorders.size() + 1, 0);
+        for (size_t r = 0; r < recorders.size(); r++) {
+            const G &g = recorders[r]->*geometry;
+            first_element[r + 1] = first_element[r] + g.vbo.Size();
+            first_index[r + 1] = first_index[r] + g.ebo.Size();
+        }
+        if (first_element.back() == 0) {
+            return;
+        }
+
+        auto base_index = static_cast<GLuint>(buffer.VBO().Size());
+        auto elements = buffer.VBO().Extend(first_element.back());
+        auto indices = buffer.EBO().Extend(first_index.back());
+
+        auto copy = [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++) {
+                const G &g = recorders[r]->*geometry;
+                std::copy(g.vbo.elements.begin(), g.vbo.elements.end(),
+                          elements.begin() +
+                              static_cast<ptrdiff_t>(first_element[r]));
+                const auto offset =
+                    base_index + static_cast<GLuint>(first_element[r]);
+                std::transform(
+                    g.ebo.elements.begin(), g.ebo.elements.end(),
+                    indices.begin() + static_cast<ptrdiff_t>(first_index[r]),
+                    [offset](GLuint index) { return index + offset; });
+            }
+        };
+        // one recorder per thread at most, small merges stay on this thread
+        constexpr size_t kMinElementsForThreads = 65536;
+        ParallelFor(recorders.size(),
+                    first_element.back() < kMinElementsForThreads
+                        ? recorders.size()
+                        : 1,
+                    copy);
+    }
+
     // buffers to render
     line::Buffer line_buffer;
     point::Buffer point_buffer;
     circle::Buffer circle_buffer;
 
+    // optional simplified levels of line_buffer
+    line::LOD line_lod;
+
     // attributes for rendering
     glm::vec4 color{1.0F};
     float size = 1.0F;
 
+    // changes to rendering settings, see Generation
+    uint64_t settings_generation = 0;
+
     // line drawing state
     size_t line_counter = 0;
     glm::vec3 line_prev{0.0F};
     glm::vec4 color_prev{1.0F};
     float size_prev = 1.0F;
 
+    // line buffer to draw for the given camera transform
+    auto SelectLineBuffer(const glm::mat4 &mvp, const glm::vec2 &screen_size)
+        -> line::Buffer & {
+        return line_lod.Select(mvp, screen_size);
+    }
+
     friend class Renderer;
 };
 
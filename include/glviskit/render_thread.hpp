@@ -0,0 +1,456 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <glm/glm.hpp>
+#include <memory>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "camera.hpp"
+#include "gl/counters.hpp"
+#include "memory.hpp"
+#include "profiler.hpp"
+#include "recorder.hpp"
+#include "render_buffer.hpp"
+#include "renderer.hpp"
+#include "triple_buffer.hpp"
+
+namespace glviskit {
+
+// for what needs the render thread stopped, running tells whether it runs
+inline void ThrowIfThreaded(bool running, const char *what) {
+    if (running) {
+        throw std::runtime_error(std::string{what} +
+                                 " needs the render thread stopped");
+    }
+}
+
+// Everything the user thread hands over to the render thread for one frame,
+// the contents of the render buffers it drives and the camera of every
+// window.
+class Frame {
+   public:
+    struct Buffer {
+        std::shared_ptr<RenderBuffer> target;
+        Recorder recorder;
+    };
+
+    struct View {
+        uint32_t window_id;
+        Camera camera;
+        // changes whenever the camera did, see CameraHandoff
+        uint64_t version;
+    };
+
+    auto Record(const std::shared_ptr<RenderBuffer> &buffer) -> Recorder & {
+        for (auto &entry : buffers) {
+            if (entry.target == buffer) {
+                return entry.recorder;
+            }
+        }
+        buffers.push_back({.target = buffer, .recorder = {}});
+        return buffers.back().recorder;
+    }
+
+    void SetView(uint32_t window_id, const Camera &camera, uint64_t version) {
+        views.push_back(
+            {.window_id = window_id, .camera = camera, .version = version});
+    }
+
+    [[nodiscard]] auto GetView(uint32_t window_id) const -> const View * {
+        for (const auto &view : views) {
+            if (view.window_id == window_id) {
+                return &view;
+            }
+        }
+        return nullptr;
+    }
+
+    // render thread, restore every buffer to its saved state and append
+    // what was recorded for it
+    void Apply() const {
+        for (const auto &entry : buffers) {
+            const Recorder *recorder = &entry.recorder;
+            entry.target->Restore();
+            entry.target->Merge(std::span{&recorder, 1});
+        }
+    }
+
+    // start over, the recorders keep their memory
+    void Reset() {
+        for (auto &entry : buffers) {
+            entry.recorder.Clear();
+            // slots rotate, so every frame starts from the defaults
+            entry.recorder.Color(glm::vec4{1.0F});
+            entry.recorder.Size(1.0F);
+        }
+        views.clear();
+    }
+
+   private:
+    // a deque never moves its elements on push_back
+    std::deque<Buffer> buffers;
+    std::vector<View> views;
+};
+
+// Camera of a window while a render thread runs. The user thread keeps
+// changing its own camera, the renderer draws with a copy that only frames
+// update. Versions count on the user side, so a changed camera is noticed
+// even when the frame that first carried it was skipped.
+class CameraHandoff {
+   public:
+    // user thread
+    void Publish(uint32_t window_id, const std::shared_ptr<Camera> &camera,
+                 Frame &frame) {
+        if (camera.get() != source ||
+            camera->Generation() != source_generation) {
+            source = camera.get();
+            source_generation = camera->Generation();
+            version++;
+        }
+        frame.SetView(window_id, *camera, version);
+    }
+
+    // render thread, returns whether target changed
+    auto Apply(uint32_t window_id, const Frame &frame, Camera &target)
+        -> bool {
+        const Frame::View *view = frame.GetView(window_id);
+        if (view == nullptr || view->version == applied) {
+            return false;
+        }
+        applied = view->version;
+        target = view->camera;
+        return true;
+    }
+
+   private:
+    const Camera *source{nullptr};
+    uint64_t source_generation{0};
+    uint64_t version{0};
+    uint64_t applied{0};
+};
+
+// Thread rendering for a window manager. The user thread records frames
+// and publishes them through a TripleBuffer, the render thread applies the
+// newest one and draws, and sleeps while there is neither a new frame nor
+// anything else to draw. Publishing never waits, not for the GPU and not
+// for a swap blocked on vsync.
+class RenderThread {
+   public:
+    RenderThread() = default;
+    RenderThread(const RenderThread &) = delete;
+    auto operator=(const RenderThread &) -> RenderThread & = delete;
+    RenderThread(RenderThread &&) = delete;
+    auto operator=(RenderThread &&) -> RenderThread & = delete;
+    ~RenderThread() { Stop(); }
+
+    // render runs on the thread with the newest frame, or nullptr if there
+    // is none since the last call, and returns whether it drew anything.
+    // finish runs on the thread before it ends, e.g. to release contexts.
+    void Start(std::function<bool(const Frame *)> render,
+               std::function<void()> finish) {
+        if (Running()) {
+            return;
+        }
+        frames = std::make_unique<TripleBuffer<Frame>>();
+        running.store(true, std::memory_order_release);
+        thread = std::thread{
+            [this, render = std::move(render), finish = std::move(finish)] {
+                Run(render);
+                finish();
+            }};
+    }
+
+    // the newest published frame is drawn before the thread ends
+    void Stop() {
+        if (!Running()) {
+            return;
+        }
+        running.store(false, std::memory_order_release);
+        Wake();
+        thread.join();
+        frames.reset();
+        driven.clear();
+    }
+
+    [[nodiscard]] auto Running() const -> bool { return thread.joinable(); }
+
+    // Recorder for the contents of buffer in the frame being recorded,
+    // valid until the next Publish. Once recorded, a buffer is driven by
+    // frames: each one restores it to its saved state and appends its
+    // recording, which is empty if the frame did not record the buffer.
+    auto Record(const std::shared_ptr<RenderBuffer> &buffer) -> Recorder & {
+        if (!Running()) {
+            throw std::runtime_error(
+                "Recording frames needs the render thread, start it first");
+        }
+        Drive(buffer);
+        return frames->Back().Record(buffer);
+    }
+
+    // let frames drive buffer as if it was recorded, e.g. for the buffers
+    // of the windows the render thread draws
+    void Drive(const std::shared_ptr<RenderBuffer> &buffer) {
+        if (std::ranges::find(driven, buffer) == driven.end()) {
+            driven.push_back(buffer);
+        }
+    }
+
+    // frame being recorded, e.g. for the cameras
+    auto Back() -> Frame & { return frames->Back(); }
+
+    void Publish() {
+        Frame &frame = frames->Back();
+        // frames may be skipped, so each one holds all driven buffers
+        for (const auto &buffer : driven) {
+            frame.Record(buffer);
+        }
+        frames->Publish();
+        frames->Back().Reset();
+        Wake();
+    }
+
+    // let the render thread look for work, e.g. after events
+    void Wake() {
+        wake.fetch_add(1, std::memory_order_release);
+        wake.notify_one();
+    }
+
+   private:
+    std::thread thread;
+    std::atomic<bool> running{false};
+    // counts publishes and wake ups, the render thread sleeps on it
+    std::atomic<uint64_t> wake{0};
+    std::unique_ptr<TripleBuffer<Frame>> frames;
+
+    // user thread, buffers driven since the start
+    std::vector<std::shared_ptr<RenderBuffer>> driven;
+
+    void Run(const std::function<bool(const Frame *)> &render) {
+        while (running.load(std::memory_order_acquire)) {
+            // read before looking for work, so a wake up in between
+            // makes the wait below return at once
+            const uint64_t seen = wake.load(std::memory_order_acquire);
+            const Frame *frame = frames->Acquire() ? &frames->Front() : nullptr;
+            if (!render(frame) && running.load(std::memory_order_acquire)) {
+                wake.wait(seen, std::memory_order_acquire);
+            }
+        }
+        if (frames->Acquire()) {
+            render(&frames->Front());
+        }
+    }
+};
+
+// Render thread state of a window, the same for every backend. Without a
+// render thread the renderer draws with the user's camera, with one it
+// draws with a copy that published frames update.
+class WindowThreadState {
+   public:
+    explicit WindowThreadState(Renderer &renderer)
+        : camera{renderer.GetCamera()} {}
+
+    [[nodiscard]] auto GetCamera() const -> const std::shared_ptr<Camera> & {
+        return camera;
+    }
+
+    // returns whether the renderer draws with cam right away
+    auto SetCamera(Renderer &renderer, std::shared_ptr<Camera> cam) -> bool {
+        camera = std::move(cam);
+        if (threaded) {
+            return false;
+        }
+        renderer.SetCamera(camera);
+        return true;
+    }
+
+    void EnsureNotThreaded(const char *what) const {
+        ThrowIfThreaded(threaded, what);
+    }
+
+    // while no render thread runs
+    void SetThreaded(Renderer &renderer, bool enabled) {
+        threaded = enabled;
+        renderer.SetCamera(enabled ? std::make_shared<Camera>(*camera)
+                                   : camera);
+    }
+
+    // user thread, viewport is the size of the window in pixels
+    void Publish(uint32_t window_id, glm::vec2 viewport, Frame &frame) {
+        camera->SetViewportSize(viewport);
+        handoff.Publish(window_id, camera, frame);
+    }
+
+    // render thread, returns whether the camera changed
+    auto Apply(uint32_t window_id, const Frame &frame, Renderer &renderer)
+        -> bool {
+        return handoff.Apply(window_id, frame, *renderer.GetCamera());
+    }
+
+   private:
+    std::shared_ptr<Camera> camera;
+    CameraHandoff handoff;
+    bool threaded{false};
+};
+
+// Rendering of the windows of a manager, the same for every backend: on
+// the calling thread, or on a RenderThread fed by Record and Publish.
+// Windows maps ids to windows, which hand their GL context over between
+// threads with ReleaseContext and MakeCurrent, the hook of each backend.
+template <typename Windows>
+class WindowRendering {
+   public:
+    explicit WindowRendering(Windows &windows) : windows{windows} {}
+    WindowRendering(const WindowRendering &) = delete;
+    auto operator=(const WindowRendering &) -> WindowRendering & = delete;
+    WindowRendering(WindowRendering &&) = delete;
+    auto operator=(WindowRendering &&) -> WindowRendering & = delete;
+    ~WindowRendering() { Stop(); }
+
+    // render all windows, returns whether any window drew a frame
+    auto Render() -> bool {
+        EnsureNotThreaded("Render");
+        return RenderFrame(nullptr);
+    }
+
+    // draw the windows, only those out of date with render on demand,
+    // returns whether any window drew a frame
+    auto RenderWindows() -> bool {
+        bool rendered = false;
+        for (auto &[id, window] : windows) {
+            if (render_on_demand) {
+                rendered = window->RenderIfChanged() || rendered;
+            } else {
+                window->Render();
+                rendered = true;
+            }
+        }
+        if (rendered) {
+            GLCallCounter::GetInstance().EndFrame();
+        }
+        return rendered;
+    }
+
+    // frames drive every buffer of a window from the start and restore it
+    // to its saved state, see RenderThread::Record, so what it holds now is
+    // saved first instead of vanishing with the first frame
+    void Start() {
+        if (thread.Running()) {
+            return;
+        }
+        for (auto &[id, window] : windows) {
+            window->SetThreaded(true);
+            for (const auto &buffer : window->renderer.GetRenderBuffers()) {
+                buffer->Save();
+                thread.Drive(buffer);
+            }
+        }
+        ReleaseContext();
+        thread.Start([this](const Frame *frame) { return RenderFrame(frame); },
+                     [this] { ReleaseContext(); });
+    }
+
+    void Stop() {
+        if (!thread.Running()) {
+            return;
+        }
+        thread.Stop();
+        for (auto &[id, window] : windows) {
+            window->SetThreaded(false);
+        }
+        if (!windows.empty()) {
+            windows.begin()->second->MakeCurrent();
+        }
+    }
+
+    [[nodiscard]] auto Running() const -> bool { return thread.Running(); }
+
+    auto Record(const std::shared_ptr<RenderBuffer> &buffer) -> Recorder & {
+        return thread.Record(buffer);
+    }
+
+    // hand the recorded frame and the cameras to the render thread
+    void Publish() {
+        if (!thread.Running()) {
+            return;
+        }
+        for (auto &[id, window] : windows) {
+            window->PublishCamera(thread.Back());
+        }
+        thread.Publish();
+    }
+
+    void SetRenderOnDemand(bool enabled) { render_on_demand = enabled; }
+    [[nodiscard]] auto GetRenderOnDemand() const -> bool {
+        return render_on_demand;
+    }
+
+    void EnsureNotThreaded(const char *what) const {
+        ThrowIfThreaded(thread.Running(), what);
+    }
+
+    // memory of the created buffers that are still alive and of every
+    // window with its buffers, buffers shared between them count once
+    [[nodiscard]] auto MemoryUsage(
+        const std::vector<std::weak_ptr<RenderBuffer>> &created) const
+        -> MemoryReport {
+        EnsureNotThreaded("MemoryUsage");
+        MemoryReport report;
+        std::set<const RenderBuffer *> counted;
+        auto add = [&](const RenderBuffer &buffer) {
+            if (counted.insert(&buffer).second) {
+                report += buffer.MemoryUsage();
+            }
+        };
+        for (const auto &weak : created) {
+            if (auto buffer = weak.lock()) {
+                add(*buffer);
+            }
+        }
+        for (const auto &[id, window] : windows) {
+            for (const auto &buffer : window->renderer.GetRenderBuffers()) {
+                add(*buffer);
+            }
+            report.target_bytes += window->TargetMemoryBytes();
+        }
+        return report;
+    }
+
+   private:
+    Windows &windows;
+    std::atomic<bool> render_on_demand{false};
+    RenderThread thread;
+
+    // render thread, or the user thread without one
+    auto RenderFrame(const Frame *frame) -> bool {
+        if (frame != nullptr) {
+            frame->Apply();
+            for (auto &[id, window] : windows) {
+                window->ApplyFrame(*frame);
+            }
+        }
+        auto &profiler = Profiler::GetInstance();
+        profiler.BeginFrame();
+        bool rendered = RenderWindows();
+        profiler.EndFrame(rendered);
+        return rendered;
+    }
+
+    // a context is current on one thread at a time
+    void ReleaseContext() {
+        if (!windows.empty()) {
+            windows.begin()->second->ReleaseContext();
+        }
+    }
+};
+
+}  // namespace glviskit
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <memory>
 #include <utility>
@@ -7,18 +10,35 @@
 
 #include "camera.hpp"
 #include "gl/gl.hpp"
+#include "gl/oit.hpp"
+#include "gl/timer.hpp"
+#include "hud.hpp"
+#include "memory.hpp"
 #include "primitive/circle.hpp"
 #include "primitive/line.hpp"
 #include "primitive/point.hpp"
 #include "render_buffer.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 
 namespace glviskit {
 
+// how translucent points and circles are composited
+enum class Transparency {
+    // multisampled alpha to coverage, cheap but order dependent
+    AlphaToCoverage,
+    // weighted blended order-independent transparency, lines stay opaque
+    WeightedBlended,
+};
+
 class Renderer {
    public:
     Renderer() : camera{std::make_shared<Camera>()} {}
 
     void Render(GLuint ctx_id, int _width, int _height) {
+        TraceScope trace{"Renderer::Render"};
+        const auto start = std::chrono::steady_clock::now();
+
         // if gl context not initialized, do it now
         if (!initialized_) {
             InitializeContext();
@@ -36,29 +56,39 @@ class Renderer {
 
         // get camera transform matrix
         auto mvp = camera->CalculateTransform();
+        const glm::vec2 screen_size{width, height};
+
+        timer.BeginFrame();
 
         // Render all line buffers
-        program_line->Use();
-        program_line->SetScreenSize({width, height});
-        program_line->SetMVP(mvp);
-        for (auto &line_buf : buffers) {
-            line_buf->line_buffer.Render(ctx_id);
-        }
+        UseProgram(*program_line, mvp, screen_size);
+        RenderLines(ctx_id, mvp, screen_size);
+
+        if (transparency == Transparency::WeightedBlended &&
+            BeginOIT(_width, _height)) {
+            // lines stay opaque, draw their depth into the OIT targets
+            // so they still occlude translucent points and circles
+            program_line->Use();
+            RenderLines(ctx_id, mvp, screen_size);
 
-        // Render all point buffers
-        program_point->Use();
-        program_point->SetScreenSize({width, height});
-        program_point->SetMVP(mvp);
-        for (auto &point_buf : buffers) {
-            point_buf->point_buffer.Render(ctx_id);
+            oit::Pass::Accumulate();
+            RenderPoints(*program_point_oit, ctx_id, mvp, screen_size);
+            RenderCircles(*program_circle_oit, ctx_id, mvp, screen_size);
+
+            {
+                TraceScope trace{"composite"};
+                timer.Begin(GPUTimer::Pass::Composite);
+                oit_pass->Composite();
+                timer.End();
+            }
+        } else {
+            RenderPoints(*program_point, ctx_id, mvp, screen_size);
+            RenderCircles(*program_circle, ctx_id, mvp, screen_size);
         }
+        timer.EndFrame();
 
-        // Render all circle buffers
-        program_circle->Use();
-        program_circle->SetScreenSize({width, height});
-        program_circle->SetMVP(mvp);
-        for (auto &circle_buf : buffers) {
-            circle_buf->circle_buffer.Render(ctx_id);
+        if (hud_enabled) {
+            RenderHUD(start, screen_size);
         }
     }
 
@@ -66,9 +96,66 @@ class Renderer {
         buffers.push_back(render_buffer);
     }
 
+    // sum of camera and buffer generations, grows on any change
+    [[nodiscard]] auto Generation() const -> uint64_t {
+        uint64_t generation = camera->Generation();
+        for (const auto &buffer : buffers) {
+            generation += buffer->Generation();
+        }
+        return generation;
+    }
+
     auto GetCamera() -> std::shared_ptr<Camera> { return camera; }
     void SetCamera(std::shared_ptr<Camera> cam) { camera = std::move(cam); }
 
+    void SetTransparency(Transparency mode) { transparency = mode; }
+    [[nodiscard]] auto GetTransparency() const -> Transparency {
+        return transparency;
+    }
+
+    // memory of all render buffers and of the transparency targets
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        MemoryReport report;
+        for (const auto &buffer : buffers) {
+            report += buffer->MemoryUsage();
+        }
+        report.target_bytes += TargetMemoryBytes();
+        return report;
+    }
+
+    [[nodiscard]] auto TargetMemoryBytes() const -> size_t {
+        return oit_pass ? oit_pass->MemoryBytes() : 0;
+    }
+
+    [[nodiscard]] auto GetRenderBuffers() const
+        -> const std::vector<std::shared_ptr<RenderBuffer>> & {
+        return buffers;
+    }
+
+    // measure GPU time per primitive pass, and per render buffer if
+    // per_buffer is set, results show up in GetFrameStats a few frames later
+    void SetGPUTiming(bool enabled, bool per_buffer = false) {
+        timer.SetEnabled(enabled, per_buffer);
+        hud_timing = false;
+    }
+    [[nodiscard]] auto GetFrameStats() const -> const FrameStats & {
+        return timer.Stats();
+    }
+
+    // performance overlay, turns GPU timing on while shown
+    // unless it was already enabled
+    void SetHUD(bool enabled) {
+        if (enabled && !timer.Enabled()) {
+            timer.SetEnabled(true, false);
+            hud_timing = true;
+        } else if (!enabled && hud_timing) {
+            timer.SetEnabled(false, false);
+            hud_timing = false;
+        }
+        hud_enabled = enabled;
+    }
+    [[nodiscard]] auto GetHUD() const -> bool { return hud_enabled; }
+
    private:
     void InitializeContext() {
         program_line = std::make_unique<line::Program>();
@@ -88,11 +175,106 @@ class Renderer {
         initialized_ = true;
     }
 
+    // OIT resources are only created once the mode is used
+    auto BeginOIT(int width, int height) -> bool {
+        if (!oit_pass) {
+            oit_pass = std::make_unique<oit::Pass>();
+            program_point_oit = std::make_unique<point::ProgramOIT>();
+            program_circle_oit = std::make_unique<circle::ProgramOIT>();
+        }
+        return oit_pass->Begin(width, height);
+    }
+
+    // the overlay is created on first use and kept while hidden,
+    // its text is refreshed a few times per second
+    void RenderHUD(std::chrono::steady_clock::time_point start,
+                   const glm::vec2 &screen_size) {
+        TraceScope trace{"hud"};
+        if (!hud_overlay) {
+            hud_overlay = std::make_unique<hud::Overlay>();
+        }
+        hud_overlay->AddFrame(std::chrono::duration<double, std::milli>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count());
+        if (hud_overlay->RefreshDue()) {
+            const auto &stats = timer.Stats();
+            hud_overlay->Refresh(stats.frames > 0 ? stats.total.Last() : -1.0,
+                                 MemoryUsage().GPUBytes());
+        }
+        hud_overlay->Render(screen_size);
+    }
+
+    template <typename P>
+    static void UseProgram(P &program, const glm::mat4 &mvp,
+                           const glm::vec2 &screen_size) {
+        program.Use();
+        program.SetScreenSize(screen_size);
+        program.SetMVP(mvp);
+    }
+
+    // draw every buffer within a timer query, one per buffer if requested
+    template <typename F>
+    void TimedPass(GPUTimer::Pass pass, F &&draw) {
+        TraceScope trace{GPUTimer::PassName(pass)};
+        if (!timer.PerBuffer()) {
+            timer.Begin(pass);
+            for (auto &buffer : buffers) {
+                draw(*buffer);
+            }
+            timer.End();
+            return;
+        }
+        for (size_t i = 0; i < buffers.size(); i++) {
+            timer.Begin(pass, i);
+            draw(*buffers[i]);
+            timer.End();
+        }
+    }
+
+    void RenderLines(GLuint ctx_id, const glm::mat4 &mvp,
+                     const glm::vec2 &screen_size) {
+        TimedPass(GPUTimer::Pass::Lines, [&](RenderBuffer &line_buf) {
+            line_buf.SelectLineBuffer(mvp, screen_size).Render(ctx_id);
+        });
+    }
+
+    template <typename P>
+    void RenderPoints(P &program, GLuint ctx_id, const glm::mat4 &mvp,
+                      const glm::vec2 &screen_size) {
+        UseProgram(program, mvp, screen_size);
+        TimedPass(GPUTimer::Pass::Points, [&](RenderBuffer &point_buf) {
+            point_buf.point_buffer.Render(ctx_id);
+        });
+    }
+
+    template <typename P>
+    void RenderCircles(P &program, GLuint ctx_id, const glm::mat4 &mvp,
+                       const glm::vec2 &screen_size) {
+        UseProgram(program, mvp, screen_size);
+        TimedPass(GPUTimer::Pass::Circles, [&](RenderBuffer &circle_buf) {
+            circle_buf.circle_buffer.Render(ctx_id);
+        });
+    }
+
     // TODO: share programs across multiple renderers?
     std::unique_ptr<line::Program> program_line{nullptr};
     std::unique_ptr<point::Program> program_point{nullptr};
     std::unique_ptr<circle::Program> program_circle{nullptr};
 
+    // weighted blended transparency
+    Transparency transparency{Transparency::AlphaToCoverage};
+    std::unique_ptr<oit::Pass> oit_pass{nullptr};
+    std::unique_ptr<point::ProgramOIT> program_point_oit{nullptr};
+    std::unique_ptr<circle::ProgramOIT> program_circle_oit{nullptr};
+
+    // GPU pass timing
+    GPUTimer timer;
+
+    // performance overlay, hud_timing is set if it enabled the timer
+    std::unique_ptr<hud::Overlay> hud_overlay{nullptr};
+    bool hud_enabled{false};
+    bool hud_timing{false};
+
     // make camera shareable across windows
     std::shared_ptr<Camera> camera;
     bool initialized_{false};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <iostream>
+
+#include "../gl/buffer_storage.hpp"
+#include "../gl/debug.hpp"
+#include "../gl/gl.hpp"
+#include "sdl.hpp"
+
+namespace glviskit::sdl {
+
+// request the GL version and framebuffer glviskit renders with,
+// must be called after SDL_Init and before creating any window
+inline void SetGLAttributes() {
+#if defined(GLVISKIT_GL33)
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+                        SDL_GL_CONTEXT_PROFILE_CORE);
+#elif defined(GLVISKIT_GLES3)
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+                        SDL_GL_CONTEXT_PROFILE_ES);
+#else
+#error "No GL version defined"
+#endif
+    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
+    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
+#if GLVISKIT_GL_DEBUG
+    // debug contexts are required to report debug output
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+#endif
+}
+
+// load glad after context creation
+inline void LoadGLAD() {
+#if defined(GLVISKIT_USE_GLAD_GL)
+    int ret = gladLoadGL((GLADloadfunc)SDL_GL_GetProcAddress);
+#elif defined(GLVISKIT_USE_GLAD_GLES2)
+    int ret = gladLoadGLES2((GLADloadfunc)SDL_GL_GetProcAddress);
+#else
+    int ret = 1;
+#endif
+    if (ret == 0) {
+        std::cerr << "Failed to initialize GLAD" << '\n';
+        exit(EXIT_FAILURE);
+    }
+
+    // optional functions outside the loaded core set
+    LoadBufferStorage(SDL_GL_GetProcAddress);
+    LoadDebugOutput(SDL_GL_GetProcAddress);
+
+    std::cerr << "OpenGL Version: " << glGetString(GL_VERSION) << '\n';
+    std::cerr << "OpenGL Renderer: " << glGetString(GL_RENDERER) << '\n';
+}
+
+}  // namespace glviskit::sdl
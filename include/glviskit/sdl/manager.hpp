@@ -2,9 +2,18 @@
 
 #include <iostream>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
+#include "../gl/debug.hpp"
 #include "../gl/gl.hpp"
+#include "../memory.hpp"
+#include "../profiler.hpp"
+#include "../recorder.hpp"
 #include "../render_buffer.hpp"
+#include "../render_thread.hpp"
+#include "../trace.hpp"
+#include "context.hpp"
 #include "window.hpp"
 
 namespace glviskit::sdl {
@@ -23,6 +32,7 @@ class Manager {
     auto operator=(Manager &&) -> Manager & = delete;
 
     ~Manager() {
+        StopRenderThread();
         windows_.clear();
 
         SDL_Quit();
@@ -30,6 +40,7 @@ class Manager {
 
     auto CreateWindow(const char *title, int w, int h)
         -> std::shared_ptr<Window> {
+        rendering_.EnsureNotThreaded("CreateWindow");
         std::shared_ptr<Window> window;
 
         if (!windows_.empty()) {
@@ -42,26 +53,87 @@ class Manager {
             LoadGLAD();
         }
 
+        // the new window's context is current here
+        EnableDebugOutput();
+
         windows_.insert({window->GetWindowID(), window});
         return window;
     }
 
+    // with a render thread this only handles events and publishes the
+    // recorded frame, it never waits for rendering
     auto Loop() -> bool {
-        Render();
+        TraceScope trace{"Manager::Loop"};
+        if (rendering_.Running()) {
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                if (!ProcessEvent(event)) {
+                    return false;
+                }
+            }
+            Publish();
+            return true;
+        }
+
+        auto &profiler = Profiler::GetInstance();
+        profiler.BeginFrame();
+        bool rendered = rendering_.RenderWindows();
 
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        // nothing changed, so there is no swap to throttle the loop,
+        // wait for events for a while instead of spinning
+        if (!rendered && rendering_.GetRenderOnDemand() &&
+            SDL_WaitEventTimeout(&event, kIdleWaitMs)) {
             if (!ProcessEvent(event)) {
                 return false;
             }
         }
+
+        {
+            ScopedTimer timer{Profiler::Stage::Events};
+            while (SDL_PollEvent(&event)) {
+                if (!ProcessEvent(event)) {
+                    return false;
+                }
+            }
+        }
+
+        profiler.EndFrame(rendered);
         return true;
     }
 
-    void Render() {
-        for (auto &[id, window] : windows_) {
-            window->Render();
-        }
+    // render all windows, returns whether any window drew a frame
+    auto Render() -> bool { return rendering_.Render(); }
+
+    // Render on a thread of its own that takes over the GL contexts, see
+    // RenderThread. Windows and render buffers have to exist before it
+    // starts. While it runs, render buffers change only through Record:
+    // every buffer of a window is saved as it is and driven by frames from
+    // the start, so it shows that state and what was recorded for it, and
+    // changing it directly would race with the thread. Window cameras
+    // reach it with every frame and other window settings need it stopped.
+    // Events are still handled by Loop on this thread.
+    void StartRenderThread() { rendering_.Start(); }
+    void StopRenderThread() { rendering_.Stop(); }
+
+    [[nodiscard]] auto RenderThreadRunning() const -> bool {
+        return rendering_.Running();
+    }
+
+    // recorder for the contents of buffer in the next published frame
+    auto Record(const std::shared_ptr<RenderBuffer> &buffer) -> Recorder & {
+        return rendering_.Record(buffer);
+    }
+
+    // hand the recorded frame and the cameras to the render thread
+    void Publish() { rendering_.Publish(); }
+
+    // skip redrawing windows whose camera and buffers did not change
+    void SetRenderOnDemand(bool enabled) {
+        rendering_.SetRenderOnDemand(enabled);
+    }
+    [[nodiscard]] auto GetRenderOnDemand() const -> bool {
+        return rendering_.GetRenderOnDemand();
     }
 
     auto ProcessEvent(const SDL_Event &event) -> bool {
@@ -94,16 +166,36 @@ class Manager {
                 if (windows_.contains(event.wheel.windowID)) {
                     windows_[event.wheel.windowID]->CallbackWheel(event.wheel);
                 }
+                break;
             default:
+                if (event.type >= SDL_EVENT_WINDOW_FIRST &&
+                    event.type <= SDL_EVENT_WINDOW_LAST &&
+                    windows_.contains(event.window.windowID)) {
+                    windows_[event.window.windowID]->CallbackWindow(
+                        event.window);
+                }
                 break;
         }
         return true;
     }
 
-    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    // memory of all windows and live render buffers, attached to a window
+    // or not, render buffers shared between windows are only counted once,
+    // the render thread changes it with every frame
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        return rendering_.MemoryUsage(buffers_);
+    }
+
     auto CreateRenderBuffer() -> std::shared_ptr<RenderBuffer> {
+        rendering_.EnsureNotThreaded("CreateRenderBuffer");
         EnsureContext();
-        return std::make_shared<RenderBuffer>();
+        auto buffer = std::make_shared<RenderBuffer>();
+        // drop buffers that are gone, the list only grows with live ones
+        std::erase_if(buffers_, [](const auto &created) {
+            return created.expired();
+        });
+        buffers_.push_back(buffer);
+        return buffer;
     }
 
     static auto GetTimeSeconds() -> float {
@@ -111,7 +203,14 @@ class Manager {
     }
 
    private:
+    // maximum time to wait for events when no window needed a redraw
+    static constexpr Sint32 kIdleWaitMs = 10;
+
     std::map<Uint32, std::shared_ptr<Window>> windows_;
+    // every render buffer created, for MemoryUsage
+    std::vector<std::weak_ptr<RenderBuffer>> buffers_;
+    WindowRendering<std::map<Uint32, std::shared_ptr<Window>>> rendering_{
+        windows_};
 
     Manager() {
         if (!SDL_Init(SDL_INIT_VIDEO)) {
@@ -124,21 +223,7 @@ class Manager {
             exit(EXIT_FAILURE);
         }
 
-#if defined(GLVISKIT_GL33)
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
-                            SDL_GL_CONTEXT_PROFILE_CORE);
-#elif defined(GLVISKIT_GLES3)
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
-                            SDL_GL_CONTEXT_PROFILE_ES);
-#else
-#error "No GL version defined"
-#endif
-        SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-        SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
+        SetGLAttributes();
     }
 
     // get any active window (for context sharing)
@@ -153,24 +238,6 @@ class Manager {
                 "No context initialized, create a window first");
         }
     }
-
-    // load glad after context creation
-    static void LoadGLAD() {
-#if defined(GLVISKIT_USE_GLAD_GL)
-        int ret = gladLoadGL((GLADloadfunc)SDL_GL_GetProcAddress);
-#elif defined(GLVISKIT_USE_GLAD_GLES2)
-        int ret = gladLoadGLES2((GLADloadfunc)SDL_GL_GetProcAddress);
-#else
-        int ret = 1;
-#endif
-        if (ret == 0) {
-            std::cerr << "Failed to initialize GLAD" << '\n';
-            exit(EXIT_FAILURE);
-        }
-
-        std::cerr << "OpenGL Version: " << glGetString(GL_VERSION) << '\n';
-        std::cerr << "OpenGL Renderer: " << glGetString(GL_RENDERER) << '\n';
-    }
 };
 
 }  // namespace glviskit::sdl
\ No newline at end of file
@@ -1,8 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <utility>
 
+#include "../gl/debug.hpp"
 #include "../gl/gl.hpp"
+#include "../gl/pixel_reader.hpp"
+#include "../gl/state.hpp"
+#include "../profiler.hpp"
+#include "../trace.hpp"
+#include "../render_thread.hpp"
 #include "../renderer.hpp"
 #include "SDL3/SDL_events.h"
 #include "sdl.hpp"
@@ -46,17 +55,59 @@ class Window {
     }
 
     void AddRenderBuffer(const std::shared_ptr<RenderBuffer> &render_buffer) {
+        thread_state_.EnsureNotThreaded("AddRenderBuffer");
         renderer.AddRenderBuffer(render_buffer);
+        damaged_ = true;
     }
 
-    auto GetCamera() -> std::shared_ptr<Camera> { return renderer.GetCamera(); }
+    // with a render thread the renderer draws with a copy of this camera
+    // taken by every published frame
+    auto GetCamera() -> std::shared_ptr<Camera> {
+        return thread_state_.GetCamera();
+    }
     void SetCamera(std::shared_ptr<Camera> cam) {
-        renderer.SetCamera(std::move(cam));
+        if (thread_state_.SetCamera(renderer, std::move(cam))) {
+            damaged_ = true;
+        }
     }
 
-    void MakeCurrent() { SDL_GL_MakeCurrent(window_.Get(), context_.Get()); }
+    void SetTransparency(Transparency mode) {
+        thread_state_.EnsureNotThreaded("SetTransparency");
+        renderer.SetTransparency(mode);
+        damaged_ = true;
+    }
+    [[nodiscard]] auto GetTransparency() const -> Transparency {
+        return renderer.GetTransparency();
+    }
+
+    // performance overlay, F1 toggles it
+    void SetHUD(bool enabled) {
+        thread_state_.EnsureNotThreaded("SetHUD");
+        renderer.SetHUD(enabled);
+        damaged_ = true;
+    }
+    [[nodiscard]] auto GetHUD() const -> bool {
+        thread_state_.EnsureNotThreaded("GetHUD");
+        return renderer.GetHUD();
+    }
+
+    void SetGPUTiming(bool enabled, bool per_buffer = false) {
+        thread_state_.EnsureNotThreaded("SetGPUTiming");
+        renderer.SetGPUTiming(enabled, per_buffer);
+    }
+    [[nodiscard]] auto GetFrameStats() const -> const FrameStats & {
+        thread_state_.EnsureNotThreaded("GetFrameStats");
+        return renderer.GetFrameStats();
+    }
+
+    void MakeCurrent() {
+        SDL_GL_MakeCurrent(window_.Get(), context_.Get());
+        gl_state_.MakeCurrent();
+    }
 
     void Render() {
+        TraceScope trace{"Window::Render"};
+
         // make context current
         // renderer expects the context to be current
         bool ret = SDL_GL_MakeCurrent(window_.Get(), context_.Get());
@@ -65,6 +116,12 @@ class Window {
                       << '\n';
             exit(EXIT_FAILURE);
         }
+        gl_state_.MakeCurrent();
+
+        // F1 is handled with the events, possibly on another thread
+        if (hud_toggles_.exchange(0) % 2 != 0) {
+            renderer.SetHUD(!renderer.GetHUD());
+        }
 
         // update screen size
         int width;
@@ -75,19 +132,70 @@ class Window {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         renderer.Render(window_id_, width, height);
 
+        // remember what was drawn for RenderIfChanged
+        rendered_generation_ = renderer.Generation();
+        damaged_ = false;
+
+        // queue readback of the back buffer before it is swapped
+        if (pixel_reader_) {
+            pixel_reader_->Queue(width, height, frame_index_);
+        }
+        frame_index_++;
+
         // swap buffers
-        SDL_GL_SwapWindow(window_.Get());
+        {
+            ScopedTimer timer{Profiler::Stage::Swap};
+            SDL_GL_SwapWindow(window_.Get());
+        }
 
-        GLenum error2 = glGetError();
-        if (error2 != GL_NO_ERROR) {
-            std::cerr << "OpenGL error in window 2: " << error2 << '\n';
-            exit(EXIT_FAILURE);
+        // no-op in release builds and with debug output
+        CheckGLError("after swap");
+    }
+
+    // render only if the window contents are out of date,
+    // returns whether a frame was drawn
+    auto RenderIfChanged() -> bool {
+        if (!visible_) {
+            return false;
+        }
+        if (!damaged_ && renderer.Generation() == rendered_generation_) {
+            return false;
+        }
+        Render();
+        return true;
+    }
+
+    void CallbackWindow(const SDL_WindowEvent &event) {
+        switch (event.type) {
+            case SDL_EVENT_WINDOW_HIDDEN:
+            case SDL_EVENT_WINDOW_MINIMIZED:
+            case SDL_EVENT_WINDOW_OCCLUDED:
+                visible_ = false;
+                break;
+            case SDL_EVENT_WINDOW_SHOWN:
+            case SDL_EVENT_WINDOW_RESTORED:
+            case SDL_EVENT_WINDOW_MAXIMIZED:
+            case SDL_EVENT_WINDOW_EXPOSED:
+                visible_ = true;
+                damaged_ = true;
+                break;
+            case SDL_EVENT_WINDOW_RESIZED:
+            case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+            case SDL_EVENT_WINDOW_DISPLAY_SCALE_CHANGED:
+                damaged_ = true;
+                break;
+            default:
+                break;
         }
     }
 
-    void CallbackKey(const SDL_KeyboardEvent &event) const {
+    void CallbackKey(const SDL_KeyboardEvent &event) {
         std::cout << "Key in window " << window_id_ << ": "
                   << SDL_GetKeyName(event.key) << " " << event.down << "  \n";
+        if (event.down && !event.repeat && event.key == SDLK_F1) {
+            hud_toggles_++;
+            damaged_ = true;
+        }
     }
 
     void CallbackButton(const SDL_MouseButtonEvent &event) const {
@@ -105,16 +213,90 @@ class Window {
                   << ", " << event.y << "  \n";
     }
 
+    // Starts reading frames back on the first call, which returns nullptr.
+    // Later calls return the newest frame whose readback finished, usually
+    // one or two frames old, or nullptr if none finished since the last
+    // call. Never waits for the GPU.
+    auto ReadPixelsAsync() -> std::shared_ptr<PixelFrame> {
+        thread_state_.EnsureNotThreaded("ReadPixelsAsync");
+        MakeCurrent();
+        if (!pixel_reader_) {
+            pixel_reader_ = std::make_unique<PixelReader>();
+            return nullptr;
+        }
+        return pixel_reader_->Poll();
+    }
+
+    // render buffers may be shared with other windows and are counted
+    // in each of them, see Manager::MemoryUsage for a deduplicated total
+    [[nodiscard]] auto MemoryUsage() const -> MemoryReport {
+        thread_state_.EnsureNotThreaded("MemoryUsage");
+        MemoryReport report = renderer.MemoryUsage();
+        report.target_bytes = TargetMemoryBytes();
+        return report;
+    }
+
+    // framebuffer and readback memory owned by the window
+    [[nodiscard]] auto TargetMemoryBytes() const -> size_t {
+        size_t bytes = renderer.TargetMemoryBytes();
+        if (pixel_reader_) {
+            bytes += pixel_reader_->MemoryBytes();
+        }
+        return bytes;
+    }
+
     [[nodiscard]] auto GetWindowID() const -> Uint32 { return window_id_; }
 
    private:
     SDLWindowPtr window_;
     SDLGLContextPtr context_;
 
+    // bindings of this window's context
+    GLState gl_state_;
     Renderer renderer;
     GLuint window_id_;
 
+    WindowThreadState thread_state_{renderer};
+
+    // asynchronous readback, created by the first ReadPixelsAsync
+    std::unique_ptr<PixelReader> pixel_reader_{nullptr};
+    uint64_t frame_index_{0};
+
+    // render on demand state, events may come from another thread
+    uint64_t rendered_generation_{0};
+    std::atomic<bool> damaged_{true};
+    std::atomic<bool> visible_{true};
+    std::atomic<unsigned> hud_toggles_{0};
+
+    // called by the manager while no render thread runs
+    void SetThreaded(bool threaded) {
+        thread_state_.SetThreaded(renderer, threaded);
+        damaged_ = true;
+    }
+
+    // user thread
+    void PublishCamera(Frame &frame) {
+        int width;
+        int height;
+        SDL_GetWindowSizeInPixels(window_.Get(), &width, &height);
+        thread_state_.Publish(
+            window_id_,
+            {static_cast<float>(width), static_cast<float>(height)}, frame);
+    }
+
+    // render thread
+    void ApplyFrame(const Frame &frame) {
+        if (thread_state_.Apply(window_id_, frame, renderer)) {
+            damaged_ = true;
+        }
+    }
+
+    // a context is current on one thread at a time
+    void ReleaseContext() { SDL_GL_MakeCurrent(window_.Get(), nullptr); }
+
     friend class Manager;
+    template <typename>
+    friend class glviskit::WindowRendering;
 };
 
 }  // namespace glviskit::sdl
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace glviskit {
+
+// Statistics over the most recent kWindow samples.
+class RollingStat {
+   public:
+    static constexpr size_t kWindow = 120;
+
+    void Add(double value) {
+        samples[next] = value;
+        next = (next + 1) % kWindow;
+        count = (std::min)(count + 1, kWindow);
+        last = value;
+    }
+
+    [[nodiscard]] auto Count() const -> size_t { return count; }
+    [[nodiscard]] auto Last() const -> double { return last; }
+
+    [[nodiscard]] auto Mean() const -> double {
+        if (count == 0) {
+            return 0.0;
+        }
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            sum += samples[i];
+        }
+        return sum / static_cast<double>(count);
+    }
+
+    [[nodiscard]] auto Min() const -> double {
+        if (count == 0) {
+            return 0.0;
+        }
+        return *std::min_element(samples.begin(), End());
+    }
+
+    [[nodiscard]] auto Max() const -> double {
+        if (count == 0) {
+            return 0.0;
+        }
+        return *std::max_element(samples.begin(), End());
+    }
+
+    void Clear() {
+        count = 0;
+        next = 0;
+        last = 0.0;
+    }
+
+   private:
+    std::array<double, kWindow> samples{};
+    size_t next{0};
+    size_t count{0};
+    double last{0.0};
+
+    [[nodiscard]] auto End() const ->
+        std::array<double, kWindow>::const_iterator {
+        return samples.begin() + static_cast<ptrdiff_t>(count);
+    }
+};
+
+// GPU time spent per primitive pass, in milliseconds.
+// Filled a few frames late since timer queries are read back without waiting.
+struct FrameStats {
+    RollingStat lines;
+    RollingStat points;
+    RollingStat circles;
+    // transparency composite, only used with weighted blended transparency
+    RollingStat composite;
+    // sum of all passes
+    RollingStat total;
+    // per render buffer in the order they were added,
+    // only filled when per buffer timing is enabled
+    std::vector<RollingStat> buffers;
+    // number of frames measured so far
+    uint64_t frames{0};
+};
+
+}  // namespace glviskit
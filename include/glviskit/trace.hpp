@@ -0,0 +1,222 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace glviskit {
+
+// Timeline recorder dumped as Chrome trace event JSON, which loads in
+// chrome://tracing and Perfetto.
+// Every thread records into its own ring of the most recent kEvents events.
+// Recording takes no locks, only the first event of a thread registers its
+// ring. GPU events are durations from timer queries placed at the CPU time
+// their pass was submitted, they go to a separate GPU track.
+class Tracer {
+   public:
+    static constexpr size_t kEvents = size_t{1} << 16;
+
+    // singleton access
+    static auto GetInstance() -> Tracer & {
+        static Tracer instance;
+        return instance;
+    }
+
+    Tracer(const Tracer &) = delete;
+    auto operator=(const Tracer &) -> Tracer & = delete;
+    Tracer(Tracer &&) = delete;
+    auto operator=(Tracer &&) -> Tracer & = delete;
+    ~Tracer() = default;
+
+    void SetEnabled(bool enabled) {
+        this->enabled.store(enabled, std::memory_order_relaxed);
+    }
+    [[nodiscard]] auto Enabled() const -> bool {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // nanoseconds since the tracer was created
+    [[nodiscard]] auto Now() const -> int64_t {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   Clock::now() - epoch)
+            .count();
+    }
+
+    // name and category must outlive the tracer, string literals in practice
+    void Record(const char *name, const char *category, int64_t start_ns,
+                int64_t duration_ns, bool gpu = false) {
+        auto &ring = ThreadRing();
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        auto &slot = ring.slots[head % kEvents];
+        const uint64_t seq = 2 * (head + 1);
+        slot.seq.store(seq - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.category.store(category, std::memory_order_relaxed);
+        slot.start_ns.store(start_ns, std::memory_order_relaxed);
+        slot.duration_ns.store(duration_ns, std::memory_order_relaxed);
+        slot.gpu.store(gpu, std::memory_order_relaxed);
+        slot.seq.store(seq, std::memory_order_release);
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    // write all recorded events as trace event JSON,
+    // events recorded concurrently may be missing
+    void Dump(std::ostream &out) {
+        std::vector<Ring *> snapshot;
+        {
+            std::lock_guard lock{rings_mutex};
+            for (auto &ring : rings) {
+                snapshot.push_back(ring.get());
+            }
+        }
+
+        out << R"({"displayTimeUnit":"ms","traceEvents":[)" << '\n';
+        out << R"({"name":"thread_name","ph":"M","pid":1,"tid":0,)"
+            << R"("args":{"name":"GPU"}})";
+        for (const auto *ring : snapshot) {
+            out << ",\n"
+                << R"({"name":"thread_name","ph":"M","pid":1,"tid":)"
+                << ring->tid << R"(,"args":{"name":"glviskit )" << ring->tid
+                << R"("}})";
+        }
+
+        for (const auto *ring : snapshot) {
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > kEvents ? head - kEvents : 0;
+            std::vector<Event> events;
+            events.reserve(head - first);
+            for (uint64_t i = first; i < head; i++) {
+                // drop slots the owning thread overwrote before or while
+                // copying them
+                const auto &slot = ring->slots[i % kEvents];
+                const uint64_t seq = 2 * (i + 1);
+                if (slot.seq.load(std::memory_order_acquire) != seq) {
+                    continue;
+                }
+                Event event{slot.name.load(std::memory_order_relaxed),
+                            slot.category.load(std::memory_order_relaxed),
+                            slot.start_ns.load(std::memory_order_relaxed),
+                            slot.duration_ns.load(std::memory_order_relaxed),
+                            slot.gpu.load(std::memory_order_relaxed)};
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.seq.load(std::memory_order_relaxed) == seq) {
+                    events.push_back(event);
+                }
+            }
+
+            for (const auto &e : events) {
+                out << ",\n"
+                    << R"({"name":")" << e.name << R"(","cat":")"
+                    << e.category << R"(","ph":"X","pid":1,"tid":)"
+                    << (e.gpu ? 0 : ring->tid)
+                    << R"(,"ts":)" << static_cast<double>(e.start_ns) / 1e3
+                    << R"(,"dur":)"
+                    << static_cast<double>(e.duration_ns) / 1e3 << "}";
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    // returns false if the file could not be written
+    auto DumpToFile(const std::string &path) -> bool {
+        std::ofstream file{path};
+        if (!file) {
+            return false;
+        }
+        Dump(file);
+        return static_cast<bool>(file);
+    }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        const char *name;
+        const char *category;
+        int64_t start_ns;
+        int64_t duration_ns;
+        bool gpu;
+    };
+
+    // seqlock around one event, seq is odd while the owning thread writes
+    // the slot and 2 * (i + 1) once it holds event i
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<const char *> name{nullptr};
+        std::atomic<const char *> category{nullptr};
+        std::atomic<int64_t> start_ns{0};
+        std::atomic<int64_t> duration_ns{0};
+        std::atomic<bool> gpu{false};
+    };
+
+    // single writer ring, head counts all events ever written
+    struct Ring {
+        int tid{0};
+        std::atomic<uint64_t> head{0};
+        std::array<Slot, kEvents> slots{};
+    };
+
+    std::atomic<bool> enabled{false};
+    Clock::time_point epoch{Clock::now()};
+
+    std::mutex rings_mutex;
+    // rings stay alive after their thread exits so its events can be dumped
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    Tracer() = default;
+
+    auto ThreadRing() -> Ring & {
+        thread_local Ring *ring = nullptr;
+        if (ring == nullptr) {
+            auto owned = std::make_unique<Ring>();
+            std::lock_guard lock{rings_mutex};
+            // tid 0 is the GPU track
+            owned->tid = static_cast<int>(rings.size()) + 1;
+            ring = owned.get();
+            rings.push_back(std::move(owned));
+        }
+        return *ring;
+    }
+};
+
+// Records the enclosing scope as a trace event while tracing is enabled.
+class TraceScope {
+   public:
+    explicit TraceScope(const char *name, const char *category = "glviskit")
+        : name{name}, category{category} {
+        auto &tracer = Tracer::GetInstance();
+        if (tracer.Enabled()) {
+            start = tracer.Now();
+        }
+    }
+
+    ~TraceScope() {
+        if (start < 0) {
+            return;
+        }
+        auto &tracer = Tracer::GetInstance();
+        tracer.Record(name, category, start, tracer.Now() - start);
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    auto operator=(const TraceScope &) -> TraceScope & = delete;
+    TraceScope(TraceScope &&) = delete;
+    auto operator=(TraceScope &&) -> TraceScope & = delete;
+
+   private:
+    const char *name;
+    const char *category;
+    // negative while tracing was disabled at construction
+    int64_t start{-1};
+};
+
+}  // namespace glviskit
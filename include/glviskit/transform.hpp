@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <glm/geometric.hpp>
+#include <glm/glm.hpp>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace glviskit {
+
+// Translation * rotation * scale, the rotation is an axis scaled by the
+// angle in radians. Same result as chaining glm::translate, glm::rotate and
+// glm::scale, written out column by column instead of as three 4x4 products.
+inline auto ComposeTransform(const glm::vec3 &position,
+                             const glm::vec3 &rotation, const glm::vec3 &scale)
+    -> glm::mat4 {
+    glm::vec3 x{1.0F, 0.0F, 0.0F};
+    glm::vec3 y{0.0F, 1.0F, 0.0F};
+    glm::vec3 z{0.0F, 0.0F, 1.0F};
+
+    const float angle = glm::length(rotation);
+    if (angle > 1e-6F) {
+        const glm::vec3 a = rotation / angle;
+        const float c = std::cos(angle);
+        const float s = std::sin(angle);
+        const glm::vec3 t = (1.0F - c) * a;
+        x = {c + t.x * a.x, t.x * a.y + s * a.z, t.x * a.z - s * a.y};
+        y = {t.y * a.x - s * a.z, c + t.y * a.y, t.y * a.z + s * a.x};
+        z = {t.z * a.x + s * a.y, t.z * a.y - s * a.x, c + t.z * a.z};
+    }
+
+    return {glm::vec4{x * scale.x, 0.0F}, glm::vec4{y * scale.y, 0.0F},
+            glm::vec4{z * scale.z, 0.0F}, glm::vec4{position, 1.0F}};
+}
+
+// Transform count points by m with the perspective divide, points that end
+// up with w <= 0, e.g. behind a perspective camera, become NaN. Four points
+// at a time with SSE2 or NEON, x, y and z of the four in separate lanes.
+inline void TransformPoints(const glm::mat4 &m, const glm::vec3 *points,
+                            size_t count, glm::vec3 *out) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    // vector types lose their alignment attributes as template arguments
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    __m128 e[16];
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            e[(c * 4) + r] = _mm_set1_ps(m[c][r]);
+        }
+    }
+    for (; i + 4 <= count; i += 4) {
+        const glm::vec3 *p = points + i;
+        const __m128 x = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+        const __m128 y = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+        const __m128 z = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+        __m128 row[4];
+        for (int r = 0; r < 4; r++) {
+            row[r] = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(e[r], x), _mm_mul_ps(e[4 + r], y)),
+                _mm_add_ps(_mm_mul_ps(e[8 + r], z), e[12 + r]));
+        }
+        // all bits set is a NaN and so is everything divided by it
+        const __m128 w =
+            _mm_or_ps(row[3], _mm_cmple_ps(row[3], _mm_setzero_ps()));
+        alignas(16) std::array<std::array<float, 4>, 3> v{};
+        for (int r = 0; r < 3; r++) {
+            _mm_store_ps(v[r].data(), _mm_div_ps(row[r], w));
+        }
+        for (size_t k = 0; k < 4; k++) {
+            out[i + k] = {v[0][k], v[1][k], v[2][k]};
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        const glm::vec3 *p = points + i;
+        const std::array<float, 4> xs{p[0].x, p[1].x, p[2].x, p[3].x};
+        const std::array<float, 4> ys{p[0].y, p[1].y, p[2].y, p[3].y};
+        const std::array<float, 4> zs{p[0].z, p[1].z, p[2].z, p[3].z};
+        const float32x4_t x = vld1q_f32(xs.data());
+        const float32x4_t y = vld1q_f32(ys.data());
+        const float32x4_t z = vld1q_f32(zs.data());
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+        float32x4_t row[4];
+        for (int r = 0; r < 4; r++) {
+            row[r] = vmlaq_n_f32(
+                vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[3][r]), x, m[0][r]), y,
+                            m[1][r]),
+                z, m[2][r]);
+        }
+        // all bits set is a NaN and so is everything divided by it
+        const float32x4_t w = vreinterpretq_f32_u32(
+            vorrq_u32(vreinterpretq_u32_f32(row[3]),
+                      vcleq_f32(row[3], vdupq_n_f32(0.0F))));
+        std::array<std::array<float, 4>, 3> v{};
+        for (int r = 0; r < 3; r++) {
+            vst1q_f32(v[r].data(), vdivq_f32(row[r], w));
+        }
+        for (size_t k = 0; k < 4; k++) {
+            out[i + k] = {v[0][k], v[1][k], v[2][k]};
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        const glm::vec3 &p = points[i];
+        std::array<float, 4> v{};
+        for (int r = 0; r < 4; r++) {
+            v[r] = (m[0][r] * p.x) + (m[1][r] * p.y) + (m[2][r] * p.z) +
+                   m[3][r];
+        }
+        if (v[3] > 0.0F) {
+            out[i] = {v[0] / v[3], v[1] / v[3], v[2] / v[3]};
+        } else {
+            out[i] = glm::vec3{std::numeric_limits<float>::quiet_NaN()};
+        }
+    }
+}
+
+}  // namespace glviskit
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace glviskit {
+
+// Lock-free handoff of snapshots from one producer thread to one consumer
+// thread. The producer fills Back and publishes it, the consumer takes the
+// newest published snapshot with Acquire and reads Front. Neither side ever
+// waits for the other, snapshots published faster than they are acquired
+// are skipped. Slots are reused, so the producer finds an old snapshot in
+// Back after publishing.
+template <typename T>
+class TripleBuffer {
+   public:
+    // producer side
+    auto Back() -> T & { return slots[back]; }
+
+    void Publish() {
+        back = middle.exchange(back | kFresh, std::memory_order_acq_rel) &
+               kIndex;
+    }
+
+    // consumer side, returns whether Front changed to a newer snapshot
+    auto Acquire() -> bool {
+        if ((middle.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+
+    auto Front() -> T & { return slots[front]; }
+
+   private:
+    // slot index in the low bits, kFresh marks a snapshot not acquired yet
+    static constexpr uint8_t kIndex = 3;
+    static constexpr uint8_t kFresh = 4;
+
+    std::array<T, 3> slots{};
+
+    // each slot is owned by exactly one of the three at any time
+    uint8_t back{0};
+    std::atomic<uint8_t> middle{1};
+    uint8_t front{2};
+};
+
+}  // namespace glviskit
@@ -1,7 +1,21 @@
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
 #include <nanobind/stl/array.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/shared_ptr.h>
+#include <nanobind/stl/vector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glviskit/glviskit.hpp>
@@ -9,10 +23,516 @@
 namespace nb = nanobind;
 using namespace nb::literals;
 
+// Input arrays are NumPy arrays or any CPU tensor with DLPack support, e.g.
+// from PyTorch or JAX. They are only read, so read-only tensors are accepted.
+
+// (N, 3) positions of any supported dtype and strides, read without copies
+using Points = nb::ndarray<nb::shape<-1, 3>, nb::device::cpu, nb::ro>;
+using Image =
+    nb::ndarray<nb::numpy, uint8_t, nb::shape<-1, -1, 4>, nb::c_contig>;
+// per element attributes of bulk calls, colors are floats in [0, 1]
+// or uint8 in [0, 255]
+using Colors = nb::ndarray<nb::shape<-1, 4>, nb::device::cpu, nb::ro>;
+using Sizes = nb::ndarray<nb::shape<-1>, nb::device::cpu, nb::ro>;
+// first point of every polyline
+using Offsets = nb::ndarray<int64_t, nb::shape<-1>, nb::c_contig,
+                            nb::device::cpu, nb::ro>;
+// row-major instance transforms, with the translation in the last column
+using Transforms = nb::ndarray<float, nb::shape<-1, 4, 4>, nb::c_contig,
+                               nb::device::cpu, nb::ro>;
+// (N, 3) results computed from points
 using Points32 =
-    nb::ndarray<float, nb::shape<-1, 3>, nb::c_contig, nb::device::cpu>;
-using Points64 =
-    nb::ndarray<double, nb::shape<-1, 3>, nb::c_contig, nb::device::cpu>;
+    nb::ndarray<nb::numpy, float, nb::shape<-1, 3>, nb::c_contig>;
+// vertices of a reservation, written in place from Python
+using VertexArray = nb::ndarray<nb::numpy, float, nb::c_contig>;
+
+namespace {
+
+// wrap frame pixels without copying, the array keeps the frame alive
+auto FrameToArray(std::shared_ptr<glviskit::PixelFrame> frame) -> Image {
+    auto *holder = new std::shared_ptr<glviskit::PixelFrame>(std::move(frame));
+    nb::capsule owner(holder, [](void *p) noexcept {
+        delete static_cast<std::shared_ptr<glviskit::PixelFrame> *>(p);
+    });
+    auto &f = **holder;
+    return {f.pixels.data(),
+            {static_cast<size_t>(f.height), static_cast<size_t>(f.width), 4},
+            owner};
+}
+
+// float16 elements, converted with glviskit::HalfToFloat
+struct Half {
+    uint16_t bits;
+};
+
+// Convert rows [begin, begin + rows) of an (N, C) array of T to packed
+// floats. Packed arrays are converted as one contiguous run, with the SIMD
+// kernels of glviskit for float64 and float16, strided arrays element by
+// element.
+template <typename T, size_t C, bool Packed>
+void ConvertRows(const void *data, const std::array<int64_t, 2> &strides,
+                 size_t begin, size_t rows, float *out) {
+    const T *src = static_cast<const T *>(data);
+    if constexpr (Packed) {
+        src += begin * C;
+        if constexpr (std::is_same_v<T, double>) {
+            glviskit::ConvertToFloat(src, rows * C, out);
+        } else if constexpr (std::is_same_v<T, Half>) {
+            static_assert(sizeof(Half) == sizeof(uint16_t));
+            glviskit::HalfToFloat(reinterpret_cast<const uint16_t *>(src),
+                                  rows * C, out);
+        } else {
+            for (size_t k = 0; k < rows * C; ++k) {
+                out[k] = static_cast<float>(src[k]);
+            }
+        }
+    } else {
+        for (size_t r = 0; r < rows; ++r) {
+            const T *row =
+                src + (static_cast<int64_t>(begin + r) * strides[0]);
+            for (size_t c = 0; c < C; ++c) {
+                const T &value = row[static_cast<int64_t>(c) * strides[1]];
+                if constexpr (std::is_same_v<T, Half>) {
+                    out[(r * C) + c] = glviskit::HalfToFloat(value.bits);
+                } else {
+                    out[(r * C) + c] = static_cast<float>(value);
+                }
+            }
+        }
+    }
+}
+
+// Rows of an (N, C) or, for C = 1, (N) array of any supported dtype and
+// strides as floats. Packed float32 rows are read in place, anything else
+// is converted a chunk at a time by the ConvertRows instance picked for the
+// dtype and layout, meant for walking the rows in order.
+template <size_t C>
+class Rows {
+   public:
+    template <typename A>
+    Rows(const A &array, const char *name)
+        : data_{array.data()},
+          count_{array.shape(0)},
+          dtype_{array.dtype()},
+          strides_{array.stride(0), C > 1 ? array.stride(1) : 1} {
+        const bool packed = strides_[0] == static_cast<int64_t>(C) &&
+                            (C == 1 || strides_[1] == 1);
+        if (packed && dtype_ == nb::dtype<float>()) {
+            direct_ = static_cast<const float *>(data_);
+        } else if (dtype_ == nb::dtype<float>()) {
+            convert_ = &ConvertRows<float, C, false>;
+        } else if (dtype_ == nb::dtype<double>()) {
+            convert_ = Select<double>(packed);
+        } else if (dtype_ == kFloat16) {
+            convert_ = Select<Half>(packed);
+        } else if (dtype_ == nb::dtype<int16_t>()) {
+            convert_ = Select<int16_t>(packed);
+        } else if (dtype_ == nb::dtype<int32_t>()) {
+            convert_ = Select<int32_t>(packed);
+        } else if (dtype_ == nb::dtype<uint8_t>()) {
+            convert_ = Select<uint8_t>(packed);
+        } else {
+            throw std::invalid_argument(
+                std::string{name} +
+                " must be float16, float32, float64, int16, int32 or uint8");
+        }
+    }
+
+    [[nodiscard]] auto Count() const -> size_t { return count_; }
+    [[nodiscard]] auto Dtype() const -> nb::dlpack::dtype { return dtype_; }
+    [[nodiscard]] auto IsFloat() const -> bool {
+        return dtype_.code ==
+               static_cast<uint8_t>(nb::dlpack::dtype_code::Float);
+    }
+
+    // the C floats of row i
+    auto operator[](size_t i) -> const float * {
+        if (direct_ != nullptr) {
+            return direct_ + (i * C);
+        }
+        if (!loaded_ || i < begin_ || i >= begin_ + kChunk) {
+            Load(i);
+        }
+        return scratch_.data() + ((i - begin_) * C);
+    }
+
+   private:
+    using Convert = void (*)(const void *, const std::array<int64_t, 2> &,
+                             size_t, size_t, float *);
+
+    static constexpr size_t kChunk = 256;
+    static constexpr nb::dlpack::dtype kFloat16{
+        static_cast<uint8_t>(nb::dlpack::dtype_code::Float), 16, 1};
+
+    const void *data_;
+    size_t count_;
+    nb::dlpack::dtype dtype_;
+    // in elements
+    std::array<int64_t, 2> strides_;
+
+    const float *direct_{nullptr};
+    Convert convert_{nullptr};
+    // converted rows [begin_, begin_ + kChunk)
+    size_t begin_{0};
+    bool loaded_{false};
+    std::array<float, kChunk * C> scratch_{};
+
+    template <typename T>
+    static auto Select(bool packed) -> Convert {
+        return packed ? &ConvertRows<T, C, true> : &ConvertRows<T, C, false>;
+    }
+
+    void Load(size_t i) {
+        begin_ = i - (i % kChunk);
+        size_t rows = (std::min)(kChunk, count_ - begin_);
+        convert_(data_, strides_, begin_, rows, scratch_.data());
+        loaded_ = true;
+    }
+};
+
+// (N, 3) positions as glm vectors
+class Positions {
+   public:
+    explicit Positions(const Points &points, const char *name = "points")
+        : rows_{points, name} {}
+
+    [[nodiscard]] auto Count() const -> size_t { return rows_.Count(); }
+
+    auto operator[](size_t i) -> glm::vec3 {
+        return glm::make_vec3(rows_[i]);
+    }
+
+   private:
+    Rows<3> rows_;
+};
+
+// Colors and sizes of the elements of a bulk call, elements without them
+// use the current color and size of the render buffer.
+class Attributes {
+   public:
+    Attributes(const glviskit::RenderBuffer &rb, size_t count,
+               const std::optional<Colors> &colors,
+               const std::optional<Sizes> &sizes)
+        : color_{rb.GetColor()}, size_{rb.GetSize()} {
+        if (colors) {
+            if (colors->shape(0) != count) {
+                throw std::invalid_argument(
+                    "colors must have one row per element");
+            }
+            colors_.emplace(*colors, "colors");
+            if (colors_->Dtype() == nb::dtype<uint8_t>()) {
+                color_scale_ = 1.0F / 255.0F;
+            } else if (!colors_->IsFloat()) {
+                throw std::invalid_argument("colors must be floats or uint8");
+            }
+        }
+        if (sizes) {
+            if (sizes->shape(0) != count) {
+                throw std::invalid_argument(
+                    "sizes must have one entry per element");
+            }
+            sizes_.emplace(*sizes, "sizes");
+        }
+    }
+
+    [[nodiscard]] auto Color(size_t i) -> glm::vec4 {
+        if (colors_) {
+            return glm::make_vec4((*colors_)[i]) * color_scale_;
+        }
+        return color_;
+    }
+
+    [[nodiscard]] auto Size(size_t i) -> float {
+        return sizes_ ? (*sizes_)[i][0] : size_;
+    }
+
+   private:
+    glm::vec4 color_;
+    float size_;
+    float color_scale_{1.0F};
+    std::optional<Rows<4>> colors_;
+    std::optional<Rows<1>> sizes_;
+};
+
+// Vertices of a bulk call as a source for glviskit::RenderBuffer::Polylines.
+// Copies convert rows on their own, so every thread filling a range of
+// polylines reads its vertices once straight from the arrays.
+class Vertices {
+   public:
+    Vertices(Positions positions, Attributes attributes)
+        : positions_{std::move(positions)},
+          attributes_{std::move(attributes)} {}
+
+    auto operator()(size_t i) -> glviskit::Vertex {
+        return {.position = positions_[i],
+                .color = attributes_.Color(i),
+                .size = attributes_.Size(i)};
+    }
+
+   private:
+    Positions positions_;
+    Attributes attributes_;
+};
+
+// Vertices filled in place from Python and added to a render buffer in one
+// pass by Commit. The array is owned by the reservation, not by the render
+// buffer, so it stays valid for as long as Python references it, whatever
+// happens to the buffer meanwhile.
+class Reservation {
+   public:
+    enum class Kind : uint8_t { Points, Circles, Lines, LineTo };
+
+    // rows are x, y, z, r, g, b, a, size
+    static constexpr size_t kColumns = 8;
+    static_assert(sizeof(glviskit::Vertex) == kColumns * sizeof(float));
+
+    // vertices start at the origin with the current color and size
+    Reservation(glviskit::RenderBuffer &rb, Kind kind, size_t count)
+        : rb_{&rb},
+          kind_{kind},
+          count_{count},
+          vertices_(kind == Kind::Lines ? count * 2 : count,
+                    {.position = glm::vec3{0.0F},
+                     .color = rb.GetColor(),
+                     .size = rb.GetSize()}) {}
+
+    // (count, 8) array, (count, 2, 8) with start and end rows for lines
+    auto Array(nb::handle owner) -> VertexArray {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto *data = reinterpret_cast<float *>(vertices_.data());
+        if (kind_ == Kind::Lines) {
+            std::array<size_t, 3> shape{count_, 2, kColumns};
+            return VertexArray(data, shape.size(), shape.data(), owner);
+        }
+        std::array<size_t, 2> shape{count_, kColumns};
+        return VertexArray(data, shape.size(), shape.data(), owner);
+    }
+
+    void Commit() {
+        if (committed_) {
+            throw std::runtime_error("reservation was already committed");
+        }
+        committed_ = true;
+
+        nb::gil_scoped_release release;
+        switch (kind_) {
+            case Kind::Points:
+                rb_->Points(vertices_);
+                break;
+            case Kind::Circles:
+                rb_->Circles(vertices_);
+                break;
+            case Kind::Lines:
+                rb_->Lines(vertices_);
+                break;
+            case Kind::LineTo:
+                rb_->LinesTo(vertices_);
+                break;
+        }
+    }
+
+    [[nodiscard]] auto Committed() const -> bool { return committed_; }
+
+   private:
+    // kept alive by the Python reservation object
+    glviskit::RenderBuffer *rb_;
+    Kind kind_;
+    size_t count_;
+    std::vector<glviskit::Vertex> vertices_;
+    bool committed_{false};
+};
+
+// Bulk calls validate their arguments with the GIL held and release it
+// while filling the buffer, the arrays must not change meanwhile and a
+// render buffer must only be filled from one thread at a time.
+void AddLines(glviskit::RenderBuffer &rb, const Points &starts,
+              const Points &ends, const std::optional<Colors> &colors,
+              const std::optional<Sizes> &sizes) {
+    Positions s{starts, "starts"};
+    Positions e{ends, "ends"};
+    if (e.Count() != s.Count()) {
+        throw std::invalid_argument(
+            "starts and ends must have the same length");
+    }
+    Attributes attributes{rb, s.Count(), colors, sizes};
+    nb::gil_scoped_release release;
+    for (size_t i = 0; i < s.Count(); ++i) {
+        rb.Line(s[i], e[i], attributes.Color(i), attributes.Size(i));
+    }
+}
+
+void AddPoints(glviskit::RenderBuffer &rb, const Points &points,
+               const std::optional<Colors> &colors,
+               const std::optional<Sizes> &sizes) {
+    Positions v{points};
+    Attributes attributes{rb, v.Count(), colors, sizes};
+    nb::gil_scoped_release release;
+    for (size_t i = 0; i < v.Count(); ++i) {
+        rb.Point(v[i], attributes.Color(i), attributes.Size(i));
+    }
+}
+
+void AddLineTo(glviskit::RenderBuffer &rb, const Points &points,
+               const std::optional<Colors> &colors,
+               const std::optional<Sizes> &sizes) {
+    Positions v{points};
+    Attributes attributes{rb, v.Count(), colors, sizes};
+    nb::gil_scoped_release release;
+    for (size_t i = 0; i < v.Count(); ++i) {
+        rb.LineTo(v[i], attributes.Color(i), attributes.Size(i));
+    }
+}
+
+// polylines start at offsets, or else are separated by rows with a NaN
+void AddPolylines(glviskit::RenderBuffer &rb, const Points &points,
+                  const std::optional<Offsets> &offsets,
+                  const std::optional<Colors> &colors,
+                  const std::optional<Sizes> &sizes) {
+    Positions v{points};
+    Attributes attributes{rb, v.Count(), colors, sizes};
+    std::vector<size_t> starts;
+    if (offsets) {
+        starts.reserve(offsets->shape(0));
+        int64_t previous = 0;
+        for (size_t p = 0; p < offsets->shape(0); p++) {
+            int64_t start = offsets->data()[p];
+            if (start < previous || start > static_cast<int64_t>(v.Count())) {
+                throw std::invalid_argument(
+                    "offsets must be non-decreasing indices into points");
+            }
+            starts.push_back(static_cast<size_t>(start));
+            previous = start;
+        }
+    }
+
+    nb::gil_scoped_release release;
+    std::vector<size_t> ends;
+    if (offsets) {
+        ends.resize(starts.size());
+        for (size_t p = 0; p < starts.size(); p++) {
+            ends[p] = p + 1 < starts.size() ? starts[p + 1] : v.Count();
+        }
+    } else {
+        // mark the separators in parallel, every range converting its own
+        // rows, then split at them
+        std::vector<uint8_t> separator(v.Count());
+        constexpr size_t kMinRowsPerThread = 65536;
+        glviskit::ParallelFor(
+            v.Count(), kMinRowsPerThread, [&](size_t begin, size_t end) {
+                Positions rows{v};
+                for (size_t i = begin; i < end; ++i) {
+                    const glm::vec3 position = rows[i];
+                    separator[i] = static_cast<uint8_t>(
+                        std::isnan(position.x) || std::isnan(position.y) ||
+                        std::isnan(position.z));
+                }
+            });
+        for (size_t i = 0; i < v.Count(); ++i) {
+            if (separator[i] != 0) {
+                if (ends.size() < starts.size()) {
+                    ends.push_back(i);
+                }
+            } else if (ends.size() == starts.size()) {
+                starts.push_back(i);
+            }
+        }
+        if (ends.size() < starts.size()) {
+            ends.push_back(v.Count());
+        }
+    }
+    rb.Polylines(Vertices{v, attributes}, starts, ends);
+}
+
+void AddCircles(glviskit::RenderBuffer &rb, const Points &points,
+                const std::optional<Colors> &colors,
+                const std::optional<Sizes> &sizes) {
+    Positions v{points};
+    Attributes attributes{rb, v.Count(), colors, sizes};
+    nb::gil_scoped_release release;
+    for (size_t i = 0; i < v.Count(); ++i) {
+        rb.Circle(v[i], attributes.Color(i), attributes.Size(i));
+    }
+}
+
+// Project or unproject points with the camera, the returned array owns its
+// rows.
+auto TransformWithCamera(const glviskit::Camera &cam, const Points &points,
+                         void (glviskit::Camera::*transform)(
+                             std::span<const glm::vec3>, std::span<glm::vec3>)
+                             const) -> Points32 {
+    Positions v{points};
+    auto *result = new std::vector<glm::vec3>(v.Count());
+    nb::capsule owner(result, [](void *p) noexcept {
+        delete static_cast<std::vector<glm::vec3> *>(p);
+    });
+    {
+        nb::gil_scoped_release release;
+        std::vector<glm::vec3> input(v.Count());
+        for (size_t i = 0; i < input.size(); ++i) {
+            input[i] = v[i];
+        }
+        (cam.*transform)(input, *result);
+    }
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float));
+    return {reinterpret_cast<float *>(result->data()), {result->size(), 3},
+            owner};
+}
+
+// append the instances, or overwrite them from first on
+void PutInstances(glviskit::RenderBuffer &rb, const Transforms &transforms,
+                  std::optional<size_t> first) {
+    nb::gil_scoped_release release;
+    std::vector<glm::mat4> matrices(transforms.shape(0));
+    for (size_t i = 0; i < matrices.size(); ++i) {
+        matrices[i] =
+            glm::transpose(glm::make_mat4(transforms.data() + (i * 16)));
+    }
+    if (first) {
+        rb.SetInstances(*first, matrices);
+    } else {
+        rb.AddInstances(matrices);
+    }
+}
+
+void PutInstances(glviskit::RenderBuffer &rb, const Points &positions,
+                  const std::optional<Points> &rotations,
+                  const std::optional<Points> &scales,
+                  std::optional<size_t> first) {
+    const size_t count = positions.shape(0);
+    if ((rotations && rotations->shape(0) != count) ||
+        (scales && scales->shape(0) != count)) {
+        throw std::invalid_argument(
+            "rotations and scales need one row per position");
+    }
+    Positions p{positions, "positions"};
+    std::optional<Positions> r;
+    std::optional<Positions> s;
+    if (rotations) {
+        r.emplace(*rotations, "rotations");
+    }
+    if (scales) {
+        s.emplace(*scales, "scales");
+    }
+
+    nb::gil_scoped_release release;
+    auto collect = [](Positions &rows) {
+        std::vector<glm::vec3> v(rows.Count());
+        for (size_t i = 0; i < v.size(); ++i) {
+            v[i] = rows[i];
+        }
+        return v;
+    };
+    auto positions_v = collect(p);
+    auto rotations_v = r ? collect(*r) : std::vector<glm::vec3>{};
+    auto scales_v = s ? collect(*s) : std::vector<glm::vec3>{};
+    if (first) {
+        rb.SetInstances(*first, positions_v, rotations_v, scales_v);
+    } else {
+        rb.AddInstances(positions_v, rotations_v, scales_v);
+    }
+}
+
+}  // namespace
 
 NB_MODULE(glviskit, m) {
     nb::set_leak_warnings(false);
@@ -29,16 +549,184 @@ NB_MODULE(glviskit, m) {
           "Run the event loop for single iteration and render all windows");
     m.def("render", &glviskit::Render, nb::call_guard<nb::gil_scoped_release>(),
           "Render all windows without processing events");
+    m.def("set_render_on_demand", &glviskit::SetRenderOnDemand, "enabled"_a,
+          "Only redraw windows whose camera or render buffers changed, "
+          "off by default");
+    m.def("set_profiling", &glviskit::SetProfiling, "enabled"_a,
+          "Record CPU time of the frame pipeline stages");
+    m.def("get_profile_report", &glviskit::GetProfileReport,
+          "Percentiles of the recorded CPU stage times");
+    m.def("get_memory_usage", &glviskit::GetMemoryUsage,
+          "Memory of all windows and live render buffers, shared ones "
+          "counted once");
+
+    m.def("set_tracing", &glviskit::SetTracing, "enabled"_a,
+          "Record a timeline of CPU scopes and GPU passes");
+    m.def("dump_trace", &glviskit::DumpTrace, "path"_a,
+          "Write the timeline as Chrome trace event JSON, false on failure");
+
+    m.def("get_gl_call_counts", &glviskit::GetGLCallCounts,
+          "GL calls of the last frame, zero unless built with GL counters");
+
+    nb::class_<glviskit::GLCallCounts>(m, "GLCallCounts")
+        .def_ro("draw_calls", &glviskit::GLCallCounts::draw_calls)
+        .def_ro("buffer_binds", &glviskit::GLCallCounts::buffer_binds)
+        .def_ro("program_switches", &glviskit::GLCallCounts::program_switches)
+        .def_ro("uploaded_bytes", &glviskit::GLCallCounts::uploaded_bytes)
+        .def_ro("elided_calls", &glviskit::GLCallCounts::elided_calls);
+
+#if defined(GLVISKIT_USE_GL_NONE)
+    m.def("get_null_gl_stats", &glviskit::GetNullGLStats,
+          "GL calls recorded by the null backend since the last reset");
+    m.def("reset_null_gl_stats", &glviskit::ResetNullGLStats,
+          "Reset the call counts of the null backend");
+
+    nb::class_<glviskit::NullGLStats>(m, "NullGLStats")
+        .def_ro("calls", &glviskit::NullGLStats::calls)
+        .def_ro("draw_calls", &glviskit::NullGLStats::draw_calls)
+        .def_ro("drawn_vertices", &glviskit::NullGLStats::drawn_vertices)
+        .def_ro("uploaded_bytes", &glviskit::NullGLStats::uploaded_bytes)
+        .def_ro("buffers", &glviskit::NullGLStats::buffers)
+        .def_ro("buffer_bytes", &glviskit::NullGLStats::buffer_bytes)
+        .def_ro("peak_buffer_bytes",
+                &glviskit::NullGLStats::peak_buffer_bytes);
+#endif
+
+    nb::class_<glviskit::MemoryReport>(m, "MemoryReport")
+        .def_ro("cpu_used_bytes", &glviskit::MemoryReport::cpu_used_bytes)
+        .def_ro("cpu_reserved_bytes",
+                &glviskit::MemoryReport::cpu_reserved_bytes)
+        .def_ro("gpu_used_bytes", &glviskit::MemoryReport::gpu_used_bytes)
+        .def_ro("gpu_reserved_bytes",
+                &glviskit::MemoryReport::gpu_reserved_bytes)
+        .def_ro("target_bytes", &glviskit::MemoryReport::target_bytes)
+        .def_ro("buffer_objects", &glviskit::MemoryReport::buffer_objects)
+        .def_ro("vertex_arrays", &glviskit::MemoryReport::vertex_arrays)
+        .def_ro("render_buffers", &glviskit::MemoryReport::render_buffers)
+        .def_prop_ro("cpu_bytes", &glviskit::MemoryReport::CPUBytes)
+        .def_prop_ro("gpu_bytes", &glviskit::MemoryReport::GPUBytes)
+        .def_prop_ro("slack_bytes", &glviskit::MemoryReport::SlackBytes)
+        .def("__repr__", [](const glviskit::MemoryReport &report) {
+            return "MemoryReport(cpu_bytes=" +
+                   std::to_string(report.CPUBytes()) +
+                   ", gpu_bytes=" + std::to_string(report.GPUBytes()) +
+                   ", slack_bytes=" + std::to_string(report.SlackBytes()) +
+                   ")";
+        });
+
+    nb::class_<glviskit::RenderBufferMemory>(m, "RenderBufferMemory")
+        .def_ro("lines", &glviskit::RenderBufferMemory::lines)
+        .def_ro("points", &glviskit::RenderBufferMemory::points)
+        .def_ro("circles", &glviskit::RenderBufferMemory::circles)
+        .def_ro("instances", &glviskit::RenderBufferMemory::instances)
+        .def_ro("line_lod", &glviskit::RenderBufferMemory::line_lod)
+        .def_ro("total", &glviskit::RenderBufferMemory::total);
 
-    nb::class_<glviskit::sdl::Window>(m, "Window")
-        .def("add_render_buffer", &glviskit::sdl::Window::AddRenderBuffer,
+    nb::class_<glviskit::ProfileSummary>(m, "ProfileSummary")
+        .def_ro("mean", &glviskit::ProfileSummary::mean)
+        .def_ro("p50", &glviskit::ProfileSummary::p50)
+        .def_ro("p95", &glviskit::ProfileSummary::p95)
+        .def_ro("p99", &glviskit::ProfileSummary::p99)
+        .def_ro("max", &glviskit::ProfileSummary::max)
+        .def("__repr__", [](const glviskit::ProfileSummary &summary) {
+            return "ProfileSummary(mean=" + std::to_string(summary.mean) +
+                   ", p50=" + std::to_string(summary.p50) +
+                   ", p95=" + std::to_string(summary.p95) +
+                   ", p99=" + std::to_string(summary.p99) +
+                   ", max=" + std::to_string(summary.max) + ")";
+        });
+
+    nb::class_<glviskit::ProfileReport>(m, "ProfileReport")
+        .def_ro("events", &glviskit::ProfileReport::events)
+        .def_ro("sync", &glviskit::ProfileReport::sync)
+        .def_ro("configure_vao", &glviskit::ProfileReport::configure_vao)
+        .def_ro("draw", &glviskit::ProfileReport::draw)
+        .def_ro("swap", &glviskit::ProfileReport::swap)
+        .def_ro("frame", &glviskit::ProfileReport::frame)
+        .def_ro("upload_bytes", &glviskit::ProfileReport::upload_bytes)
+        .def_ro("frames", &glviskit::ProfileReport::frames)
+        .def_ro("total_frames", &glviskit::ProfileReport::total_frames)
+        .def_ro("stutters", &glviskit::ProfileReport::stutters)
+        .def_ro("total_stutters", &glviskit::ProfileReport::total_stutters);
+
+    nb::enum_<glviskit::Transparency>(m, "Transparency")
+        .value("ALPHA_TO_COVERAGE", glviskit::Transparency::AlphaToCoverage,
+               "Multisampled alpha to coverage, cheap but order dependent")
+        .value("WEIGHTED_BLENDED", glviskit::Transparency::WeightedBlended,
+               "Weighted blended order-independent transparency");
+
+    nb::class_<glviskit::RollingStat>(m, "RollingStat")
+        .def_prop_ro("mean", &glviskit::RollingStat::Mean)
+        .def_prop_ro("min", &glviskit::RollingStat::Min)
+        .def_prop_ro("max", &glviskit::RollingStat::Max)
+        .def_prop_ro("last", &glviskit::RollingStat::Last)
+        .def_prop_ro("count", &glviskit::RollingStat::Count)
+        .def("__repr__", [](const glviskit::RollingStat &stat) {
+            return "RollingStat(mean=" + std::to_string(stat.Mean()) +
+                   ", min=" + std::to_string(stat.Min()) +
+                   ", max=" + std::to_string(stat.Max()) + ")";
+        });
+
+    nb::class_<glviskit::FrameStats>(m, "FrameStats")
+        .def_ro("lines", &glviskit::FrameStats::lines)
+        .def_ro("points", &glviskit::FrameStats::points)
+        .def_ro("circles", &glviskit::FrameStats::circles)
+        .def_ro("composite", &glviskit::FrameStats::composite)
+        .def_ro("total", &glviskit::FrameStats::total)
+        .def_ro("buffers", &glviskit::FrameStats::buffers)
+        .def_ro("frames", &glviskit::FrameStats::frames);
+
+    nb::class_<glviskit::Window>(m, "Window")
+        .def("add_render_buffer", &glviskit::Window::AddRenderBuffer,
              "rb"_a, "Add a RenderBuffer to the window for rendering")
-        .def_prop_rw("camera", &glviskit::sdl::Window::GetCamera,
-                     &glviskit::sdl::Window::SetCamera, "Camera of the window")
-        .def("make_current", &glviskit::sdl::Window::MakeCurrent,
+        .def_prop_rw("camera", &glviskit::Window::GetCamera,
+                     &glviskit::Window::SetCamera, "Camera of the window")
+        .def_prop_rw("transparency", &glviskit::Window::GetTransparency,
+                     &glviskit::Window::SetTransparency,
+                     "How translucent points and circles are composited")
+        .def_prop_rw("hud", &glviskit::Window::GetHUD,
+                     &glviskit::Window::SetHUD,
+                     "Whether the performance overlay is shown")
+        .def("set_gpu_timing", &glviskit::Window::SetGPUTiming,
+             "enabled"_a, "per_buffer"_a = false,
+             "Measure GPU time per primitive pass, and per render buffer if "
+             "per_buffer is set")
+        .def_prop_ro(
+            "frame_stats",
+            [](const glviskit::Window &window) {
+                return window.GetFrameStats();
+            },
+            "GPU time statistics in milliseconds, a few frames behind")
+        .def("memory_usage", &glviskit::Window::MemoryUsage,
+             "Memory of the window and its render buffers")
+        .def("make_current", &glviskit::Window::MakeCurrent,
              "Make the window's OpenGL context current")
-        .def("render", &glviskit::sdl::Window::Render,
-             "Render the window's contents");
+        .def("render", &glviskit::Window::Render,
+             "Render the window's contents")
+        .def(
+            "read_pixels_async",
+            [](glviskit::Window &window) -> std::optional<Image> {
+                auto frame = window.ReadPixelsAsync();
+                if (!frame) {
+                    return std::nullopt;
+                }
+                return FrameToArray(std::move(frame));
+            },
+            "Start or continue asynchronous readback, returns the newest "
+            "finished (height, width, 4) RGBA frame or None")
+#if defined(GLVISKIT_HEADLESS) || defined(GLVISKIT_USE_GL_NONE)
+        .def(
+            "read_pixels",
+            [](glviskit::Window &window) {
+                auto frame = std::make_shared<glviskit::PixelFrame>();
+                frame->width = window.GetWidth();
+                frame->height = window.GetHeight();
+                frame->pixels = window.ReadPixels();
+                return FrameToArray(std::move(frame));
+            },
+            "Read the last rendered frame as an (height, width, 4) RGBA array")
+#endif
+        ;
 
     nb::class_<glviskit::Camera>(m, "Camera")
         .def(
@@ -55,6 +743,25 @@ NB_MODULE(glviskit, m) {
                                    nb::c_contig>(result.data());
             },
             "Calculate the camera transformation matrix")
+        .def(
+            "project",
+            [](const glviskit::Camera &cam, const Points &points) {
+                return TransformWithCamera(cam, points,
+                                           &glviskit::Camera::Project);
+            },
+            "points"_a.noconvert(),
+            "Project (N, 3) world positions to pixel x, y from the top left "
+            "of the last rendered viewport and depth in [-1, 1], points "
+            "behind the camera become NaN")
+        .def(
+            "unproject",
+            [](const glviskit::Camera &cam, const Points &pixels) {
+                return TransformWithCamera(cam, pixels,
+                                           &glviskit::Camera::Unproject);
+            },
+            "pixels"_a.noconvert(),
+            "Unproject (N, 3) pixel x, y and depth to world positions, depth "
+            "-1 is on the near and 1 on the far plane")
         .def("perspective_fov", &glviskit::Camera::PerspectiveFov, "hfov"_a,
              "vfov"_a, "near"_a = 0.1F, "far"_a = 100.0F,
              "Set perspective projection using horizontal and vertical FOV")
@@ -97,37 +804,29 @@ NB_MODULE(glviskit, m) {
                      &glviskit::Camera::SetPreserveAspectRatio,
                      "Whether to preserve aspect ratio when resizing viewport");
 
-    nb::class_<glviskit::RenderBuffer>(m, "RenderBuffer")
-        .def(
-            "line",
-            [](glviskit::RenderBuffer &rb, const Points32 &starts,
-               const Points32 &ends) {
-                auto s = starts.view();
-                auto e = ends.view();
-                for (size_t i = 0; i < s.shape(0); ++i) {
-                    rb.Line({s(i, 0), s(i, 1), s(i, 2)},
-                            {e(i, 0), e(i, 1), e(i, 2)});
-                }
-            },
-            "starts"_a.noconvert(), "ends"_a.noconvert(),
-            "Draw multiple lines from starts to ends")
-        .def(
-            "line",
-            [](glviskit::RenderBuffer &rb, const Points64 &starts,
-               const Points64 &ends) {
-                auto s = starts.view();
-                auto e = ends.view();
-                for (size_t i = 0; i < s.shape(0); ++i) {
-                    rb.Line({static_cast<float>(s(i, 0)),
-                             static_cast<float>(s(i, 1)),
-                             static_cast<float>(s(i, 2))},
-                            {static_cast<float>(e(i, 0)),
-                             static_cast<float>(e(i, 1)),
-                             static_cast<float>(e(i, 2))});
-                }
+    nb::class_<Reservation>(m, "Reservation")
+        .def_prop_ro(
+            "array",
+            [](Reservation &reservation) {
+                return reservation.Array(nb::find(&reservation));
             },
-            "starts"_a.noconvert(), "ends"_a.noconvert(),
-            "Draw multiple lines from starts to ends")
+            "Writable (n, 8) float32 array of x, y, z, r, g, b, a, size rows, "
+            "(n, 2, 8) with start and end rows for lines")
+        .def("commit", &Reservation::Commit,
+             "Add the vertices to the render buffer, only once")
+        .def_prop_ro("committed", &Reservation::Committed,
+                     "Whether commit was called");
+
+    nb::class_<glviskit::RenderBuffer>(m, "RenderBuffer")
+        .def("memory_usage", &glviskit::RenderBuffer::MemoryUsage,
+             "Memory held by the buffer")
+        .def("memory_breakdown", &glviskit::RenderBuffer::MemoryBreakdown,
+             "Memory held by the buffer split by primitive")
+        .def("line", &AddLines, "starts"_a.noconvert(),
+             "ends"_a.noconvert(), "colors"_a = nb::none(),
+             "sizes"_a = nb::none(),
+             "Draw multiple lines from starts to ends, with optional (N, 4) "
+             "colors and (N,) sizes per line")
         .def(
             "line",
             [](glviskit::RenderBuffer &rb, const std::array<float, 3> &start,
@@ -136,54 +835,20 @@ NB_MODULE(glviskit, m) {
                         glm::make_vec3(end.data()));
             },
             "start"_a, "end"_a, "Draw a line from start to end")
-        .def(
-            "point",
-            [](glviskit::RenderBuffer &rb, const Points32 &points) {
-                auto v = points.view();
-                for (size_t i = 0; i < v.shape(0); ++i) {
-                    glm::vec3 p{v(i, 0), v(i, 1), v(i, 2)};
-                    rb.Point(p);
-                }
-            },
-            "points"_a.noconvert(), "Draw multiple points at given positions")
-        .def(
-            "point",
-            [](glviskit::RenderBuffer &rb, const Points64 &points) {
-                auto v = points.view();
-                for (size_t i = 0; i < v.shape(0); ++i) {
-                    glm::vec3 p{static_cast<float>(v(i, 0)),
-                                static_cast<float>(v(i, 1)),
-                                static_cast<float>(v(i, 2))};
-                    rb.Point(p);
-                }
-            },
-            "points"_a.noconvert(), "Draw multiple points at given positions")
+        .def("point", &AddPoints, "points"_a.noconvert(),
+             "colors"_a = nb::none(), "sizes"_a = nb::none(),
+             "Draw multiple points at given positions, with optional (N, 4) "
+             "colors and (N,) sizes per point")
         .def(
             "point",
             [](glviskit::RenderBuffer &rb, const std::array<float, 3> &p) {
                 rb.Point(glm::make_vec3(p.data()));
             },
             "p"_a, "Draw a point at position p")
-        .def(
-            "line_to",
-            [](glviskit::RenderBuffer &rb, const Points32 &points) {
-                auto v = points.view();
-                for (size_t i = 0; i < v.shape(0); ++i) {
-                    rb.LineTo({v(i, 0), v(i, 1), v(i, 2)});
-                }
-            },
-            "points"_a.noconvert(), "Call line_to for multiple points consecutively")
-        .def(
-            "line_to",
-            [](glviskit::RenderBuffer &rb, const Points64 &points) {
-                auto v = points.view();
-                for (size_t i = 0; i < v.shape(0); ++i) {
-                    rb.LineTo({static_cast<float>(v(i, 0)),
-                               static_cast<float>(v(i, 1)),
-                               static_cast<float>(v(i, 2))});
-                }
-            },
-            "points"_a.noconvert(), "Call line_to for multiple points consecutively")
+        .def("line_to", &AddLineTo, "points"_a.noconvert(),
+             "colors"_a = nb::none(), "sizes"_a = nb::none(),
+             "Call line_to for multiple points consecutively, with optional "
+             "(N, 4) colors and (N,) sizes per point")
         .def(
             "line_to",
             [](glviskit::RenderBuffer &rb, const std::array<float, 3> &p) {
@@ -191,34 +856,58 @@ NB_MODULE(glviskit, m) {
             },
             "p"_a, "Draw a line to position p")
 
+        .def("polylines", &AddPolylines, "points"_a.noconvert(),
+             "offsets"_a = nb::none(), "colors"_a = nb::none(),
+             "sizes"_a = nb::none(),
+             "Draw many polylines in one call, each starts at an index in "
+             "offsets or, without offsets, rows with a NaN separate them")
         .def("line_end", &glviskit::RenderBuffer::LineEnd,
              "End the current line sequence")
+        .def("set_line_lod", &glviskit::RenderBuffer::SetLineLOD,
+             "enabled"_a, "levels"_a = 6,
+             "Enable a level of detail pyramid for subsequent polylines")
+        .def("set_line_lod_tolerance",
+             &glviskit::RenderBuffer::SetLineLODTolerance, "pixels"_a,
+             "Set the maximum on-screen polyline simplification error")
+        .def("circle", &AddCircles, "points"_a.noconvert(),
+             "colors"_a = nb::none(), "sizes"_a = nb::none(),
+             "Draw multiple circles at given positions, with optional (N, 4) "
+             "colors and (N,) sizes per circle")
         .def(
             "circle",
-            [](glviskit::RenderBuffer &rb, const Points32 &points) {
-                auto v = points.view();
-                for (size_t i = 0; i < v.shape(0); ++i) {
-                    rb.Circle({v(i, 0), v(i, 1), v(i, 2)});
-                }
+            [](glviskit::RenderBuffer &rb, const std::array<float, 3> &pos) {
+                rb.Circle(glm::make_vec3(pos.data()));
             },
-            "points"_a.noconvert(), "Draw multiple circle at given positions")
+            "pos"_a, "Draw an circle at position pos")
         .def(
-            "circle",
-            [](glviskit::RenderBuffer &rb, const Points64 &points) {
-                auto v = points.view();
-                for (size_t i = 0; i < v.shape(0); ++i) {
-                    rb.Circle({static_cast<float>(v(i, 0)),
-                               static_cast<float>(v(i, 1)),
-                               static_cast<float>(v(i, 2))});
-                }
+            "reserve_points",
+            [](glviskit::RenderBuffer &rb, size_t n) {
+                return Reservation{rb, Reservation::Kind::Points, n};
             },
-            "points"_a.noconvert(), "Draw multiple circle at given positions")
+            "n"_a, nb::keep_alive<0, 1>(),
+            "Reserve n points to fill in place, see Reservation")
         .def(
-            "circle",
-            [](glviskit::RenderBuffer &rb, const std::array<float, 3> &pos) {
-                rb.Circle(glm::make_vec3(pos.data()));
+            "reserve_circles",
+            [](glviskit::RenderBuffer &rb, size_t n) {
+                return Reservation{rb, Reservation::Kind::Circles, n};
             },
-            "pos"_a, "Draw an circle at position pos")
+            "n"_a, nb::keep_alive<0, 1>(),
+            "Reserve n circles to fill in place, see Reservation")
+        .def(
+            "reserve_lines",
+            [](glviskit::RenderBuffer &rb, size_t n) {
+                return Reservation{rb, Reservation::Kind::Lines, n};
+            },
+            "n"_a, nb::keep_alive<0, 1>(),
+            "Reserve n separate lines to fill in place, see Reservation")
+        .def(
+            "reserve_line_to",
+            [](glviskit::RenderBuffer &rb, size_t n) {
+                return Reservation{rb, Reservation::Kind::LineTo, n};
+            },
+            "n"_a, nb::keep_alive<0, 1>(),
+            "Reserve n consecutive line_to points to fill in place, see "
+            "Reservation")
 
         .def(
             "color",
@@ -241,6 +930,43 @@ NB_MODULE(glviskit, m) {
             "rot"_a = std::array<float, 3>{0.0f, 0.0f, 0.0f},
             "scale"_a = std::array<float, 3>{1.0f, 1.0f, 1.0f},
             "Add an instance with given position, rotation and scale")
+        .def(
+            "add_instances",
+            [](glviskit::RenderBuffer &rb, const Transforms &transforms) {
+                PutInstances(rb, transforms, std::nullopt);
+            },
+            "transforms"_a,
+            "Add an instance for every row-major (4, 4) transform matrix")
+        .def(
+            "add_instances",
+            [](glviskit::RenderBuffer &rb, const Points &positions,
+               const std::optional<Points> &rotations,
+               const std::optional<Points> &scales) {
+                PutInstances(rb, positions, rotations, scales, std::nullopt);
+            },
+            "positions"_a, "rotations"_a = nb::none(), "scales"_a = nb::none(),
+            "Add an instance for every position, with optional rotations and "
+            "scales")
+        .def(
+            "set_instances",
+            [](glviskit::RenderBuffer &rb, const Transforms &transforms,
+               size_t first) { PutInstances(rb, transforms, first); },
+            "transforms"_a, "first"_a = 0,
+            "Overwrite the instances from first on with row-major (4, 4) "
+            "transform matrices")
+        .def(
+            "set_instances",
+            [](glviskit::RenderBuffer &rb, const Points &positions,
+               const std::optional<Points> &rotations,
+               const std::optional<Points> &scales, size_t first) {
+                PutInstances(rb, positions, rotations, scales, first);
+            },
+            "positions"_a, "rotations"_a = nb::none(), "scales"_a = nb::none(),
+            "first"_a = 0,
+            "Overwrite the instances from first on with positions and "
+            "optional rotations and scales")
+        .def("instance_count", &glviskit::RenderBuffer::InstanceCount,
+             "Number of instances, including the initial identity instance")
         .def("save", &glviskit::RenderBuffer::Save,
              "Save the current render buffer state")
         .def("restore", &glviskit::RenderBuffer::Restore,
@@ -1,3 +1,4 @@
+import enum
 from collections.abc import Sequence
 from typing import Annotated, overload
 
@@ -19,6 +20,181 @@ def loop() -> bool:
 def render() -> None:
     """Render all windows without processing events"""
 
+def set_render_on_demand(enabled: bool) -> None:
+    """Only redraw windows whose camera or render buffers changed, off by default"""
+
+def set_profiling(enabled: bool) -> None:
+    """Record CPU time of the frame pipeline stages"""
+
+def get_profile_report() -> ProfileReport:
+    """Percentiles of the recorded CPU stage times"""
+
+def get_memory_usage() -> MemoryReport:
+    """Memory of all windows and live render buffers, shared ones counted once"""
+
+def set_tracing(enabled: bool) -> None:
+    """Record a timeline of CPU scopes and GPU passes"""
+
+def dump_trace(path: str) -> bool:
+    """Write the timeline as Chrome trace event JSON, false on failure"""
+
+def get_gl_call_counts() -> GLCallCounts:
+    """GL calls of the last frame, zero unless built with GL counters"""
+
+class GLCallCounts:
+    @property
+    def draw_calls(self) -> int: ...
+    @property
+    def buffer_binds(self) -> int: ...
+    @property
+    def program_switches(self) -> int: ...
+    @property
+    def uploaded_bytes(self) -> int: ...
+    @property
+    def elided_calls(self) -> int: ...
+
+def get_null_gl_stats() -> NullGLStats:
+    """
+    GL calls recorded by the null backend since the last reset
+
+    Only available when built with GLVISKIT_GL_TYPE=NONE.
+    """
+
+def reset_null_gl_stats() -> None:
+    """
+    Reset the call counts of the null backend
+
+    Only available when built with GLVISKIT_GL_TYPE=NONE.
+    """
+
+class NullGLStats:
+    @property
+    def calls(self) -> int: ...
+    @property
+    def draw_calls(self) -> int: ...
+    @property
+    def drawn_vertices(self) -> int: ...
+    @property
+    def uploaded_bytes(self) -> int: ...
+    @property
+    def buffers(self) -> int: ...
+    @property
+    def buffer_bytes(self) -> int: ...
+    @property
+    def peak_buffer_bytes(self) -> int: ...
+
+class MemoryReport:
+    @property
+    def cpu_used_bytes(self) -> int: ...
+    @property
+    def cpu_reserved_bytes(self) -> int: ...
+    @property
+    def gpu_used_bytes(self) -> int: ...
+    @property
+    def gpu_reserved_bytes(self) -> int: ...
+    @property
+    def target_bytes(self) -> int: ...
+    @property
+    def buffer_objects(self) -> int: ...
+    @property
+    def vertex_arrays(self) -> int: ...
+    @property
+    def render_buffers(self) -> int: ...
+    @property
+    def cpu_bytes(self) -> int: ...
+    @property
+    def gpu_bytes(self) -> int: ...
+    @property
+    def slack_bytes(self) -> int: ...
+    def __repr__(self) -> str: ...
+
+class RenderBufferMemory:
+    @property
+    def lines(self) -> MemoryReport: ...
+    @property
+    def points(self) -> MemoryReport: ...
+    @property
+    def circles(self) -> MemoryReport: ...
+    @property
+    def instances(self) -> MemoryReport: ...
+    @property
+    def line_lod(self) -> MemoryReport: ...
+    @property
+    def total(self) -> MemoryReport: ...
+
+class ProfileSummary:
+    @property
+    def mean(self) -> float: ...
+    @property
+    def p50(self) -> float: ...
+    @property
+    def p95(self) -> float: ...
+    @property
+    def p99(self) -> float: ...
+    @property
+    def max(self) -> float: ...
+    def __repr__(self) -> str: ...
+
+class ProfileReport:
+    @property
+    def events(self) -> ProfileSummary: ...
+    @property
+    def sync(self) -> ProfileSummary: ...
+    @property
+    def configure_vao(self) -> ProfileSummary: ...
+    @property
+    def draw(self) -> ProfileSummary: ...
+    @property
+    def swap(self) -> ProfileSummary: ...
+    @property
+    def frame(self) -> ProfileSummary: ...
+    @property
+    def upload_bytes(self) -> ProfileSummary: ...
+    @property
+    def frames(self) -> int: ...
+    @property
+    def total_frames(self) -> int: ...
+    @property
+    def stutters(self) -> int: ...
+    @property
+    def total_stutters(self) -> int: ...
+
+class Transparency(enum.Enum):
+    ALPHA_TO_COVERAGE = 0
+    """Multisampled alpha to coverage, cheap but order dependent"""
+
+    WEIGHTED_BLENDED = 1
+    """Weighted blended order-independent transparency"""
+
+class RollingStat:
+    @property
+    def mean(self) -> float: ...
+    @property
+    def min(self) -> float: ...
+    @property
+    def max(self) -> float: ...
+    @property
+    def last(self) -> float: ...
+    @property
+    def count(self) -> int: ...
+    def __repr__(self) -> str: ...
+
+class FrameStats:
+    @property
+    def lines(self) -> RollingStat: ...
+    @property
+    def points(self) -> RollingStat: ...
+    @property
+    def circles(self) -> RollingStat: ...
+    @property
+    def composite(self) -> RollingStat: ...
+    @property
+    def total(self) -> RollingStat: ...
+    @property
+    def buffers(self) -> list[RollingStat]: ...
+    @property
+    def frames(self) -> int: ...
+
 class Window:
     def add_render_buffer(self, rb: RenderBuffer) -> None:
         """Add a RenderBuffer to the window for rendering"""
@@ -29,18 +205,82 @@ class Window:
 
     @camera.setter
     def camera(self, arg: Camera, /) -> None: ...
+    @property
+    def transparency(self) -> Transparency:
+        """How translucent points and circles are composited"""
+
+    @transparency.setter
+    def transparency(self, arg: Transparency, /) -> None: ...
+    @property
+    def hud(self) -> bool:
+        """Whether the performance overlay is shown"""
+
+    @hud.setter
+    def hud(self, arg: bool, /) -> None: ...
+    def set_gpu_timing(self, enabled: bool, per_buffer: bool = False) -> None:
+        """
+        Measure GPU time per primitive pass, and per render buffer if per_buffer is set
+        """
+
+    @property
+    def frame_stats(self) -> FrameStats:
+        """GPU time statistics in milliseconds, a few frames behind"""
+
+    def memory_usage(self) -> MemoryReport:
+        """Memory of the window and its render buffers"""
+
     def make_current(self) -> None:
         """Make the window's OpenGL context current"""
 
     def render(self) -> None:
         """Render the window's contents"""
 
+    def read_pixels_async(
+        self,
+    ) -> (
+        Annotated[NDArray[numpy.uint8], dict(shape=(None, None, 4), order="C")]
+        | None
+    ):
+        """
+        Start or continue asynchronous readback, returns the newest finished (height, width, 4) RGBA frame or None
+        """
+
+    def read_pixels(
+        self,
+    ) -> Annotated[NDArray[numpy.uint8], dict(shape=(None, None, 4), order="C")]:
+        """
+        Read the last rendered frame as an (height, width, 4) RGBA array
+
+        Only available when built with GLVISKIT_HEADLESS or
+        GLVISKIT_GL_TYPE=NONE.
+        """
+
 class Camera:
     def calculate_transform(
         self,
     ) -> Annotated[NDArray[numpy.float32], dict(shape=(4, 4), order="C")]:
         """Calculate the camera transformation matrix"""
 
+    def project(
+        self,
+        points: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ],
+    ) -> Annotated[NDArray[numpy.float32], dict(shape=(None, 3), order="C")]:
+        """
+        Project (N, 3) world positions to pixel x, y from the top left of the last rendered viewport and depth in [-1, 1], points behind the camera become NaN
+        """
+
+    def unproject(
+        self,
+        pixels: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ],
+    ) -> Annotated[NDArray[numpy.float32], dict(shape=(None, 3), order="C")]:
+        """
+        Unproject (N, 3) pixel x, y and depth to world positions, depth -1 is on the near and 1 on the far plane
+        """
+
     def perspective_fov(
         self,
         hfov: float,
@@ -90,7 +330,27 @@ class Camera:
     @preserve_aspect_ratio.setter
     def preserve_aspect_ratio(self, arg: bool, /) -> None: ...
 
+class Reservation:
+    @property
+    def array(self) -> Annotated[NDArray[numpy.float32], dict(order="C")]:
+        """
+        Writable (n, 8) float32 array of x, y, z, r, g, b, a, size rows, (n, 2, 8) with start and end rows for lines
+        """
+
+    def commit(self) -> None:
+        """Add the vertices to the render buffer, only once"""
+
+    @property
+    def committed(self) -> bool:
+        """Whether commit was called"""
+
 class RenderBuffer:
+    def memory_usage(self) -> MemoryReport:
+        """Memory held by the buffer"""
+
+    def memory_breakdown(self) -> RenderBufferMemory:
+        """Memory held by the buffer split by primitive"""
+
     @overload
     def line(self, start: Sequence[float], end: Sequence[float]) -> None:
         """Draw a line from start to end"""
@@ -99,13 +359,23 @@ class RenderBuffer:
     def line(
         self,
         starts: Annotated[
-            NDArray[numpy.float32], dict(shape=(None, 3), order="C", device="cpu")
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
         ],
         ends: Annotated[
-            NDArray[numpy.float32], dict(shape=(None, 3), order="C", device="cpu")
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
         ],
+        colors: Annotated[
+            NDArray, dict(shape=(None, 4), device="cpu", writable=False)
+        ]
+        | None = None,
+        sizes: Annotated[
+            NDArray, dict(shape=(None,), device="cpu", writable=False)
+        ]
+        | None = None,
     ) -> None:
-        """Draw multiple lines from starts to ends"""
+        """
+        Draw multiple lines from starts to ends, with optional (N, 4) colors and (N,) sizes per line
+        """
 
     @overload
     def point(self, p: Sequence[float]) -> None:
@@ -115,10 +385,20 @@ class RenderBuffer:
     def point(
         self,
         points: Annotated[
-            NDArray[numpy.float32], dict(shape=(None, 3), order="C", device="cpu")
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
         ],
+        colors: Annotated[
+            NDArray, dict(shape=(None, 4), device="cpu", writable=False)
+        ]
+        | None = None,
+        sizes: Annotated[
+            NDArray, dict(shape=(None,), device="cpu", writable=False)
+        ]
+        | None = None,
     ) -> None:
-        """Draw multiple points at given positions"""
+        """
+        Draw multiple points at given positions, with optional (N, 4) colors and (N,) sizes per point
+        """
 
     @overload
     def line_to(self, p: Sequence[float]) -> None:
@@ -128,14 +408,53 @@ class RenderBuffer:
     def line_to(
         self,
         points: Annotated[
-            NDArray[numpy.float32], dict(shape=(None, 3), order="C", device="cpu")
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
         ],
+        colors: Annotated[
+            NDArray, dict(shape=(None, 4), device="cpu", writable=False)
+        ]
+        | None = None,
+        sizes: Annotated[
+            NDArray, dict(shape=(None,), device="cpu", writable=False)
+        ]
+        | None = None,
     ) -> None:
-        """Call line_to for multiple points consecutively"""
+        """
+        Call line_to for multiple points consecutively, with optional (N, 4) colors and (N,) sizes per point
+        """
+
+    def polylines(
+        self,
+        points: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ],
+        offsets: Annotated[
+            NDArray[numpy.int64],
+            dict(shape=(None,), order="C", device="cpu", writable=False),
+        ]
+        | None = None,
+        colors: Annotated[
+            NDArray, dict(shape=(None, 4), device="cpu", writable=False)
+        ]
+        | None = None,
+        sizes: Annotated[
+            NDArray, dict(shape=(None,), device="cpu", writable=False)
+        ]
+        | None = None,
+    ) -> None:
+        """
+        Draw many polylines in one call, each starts at an index in offsets or, without offsets, rows with a NaN separate them
+        """
 
     def line_end(self) -> None:
         """End the current line sequence"""
 
+    def set_line_lod(self, enabled: bool, levels: int = 6) -> None:
+        """Enable a level of detail pyramid for subsequent polylines"""
+
+    def set_line_lod_tolerance(self, pixels: float) -> None:
+        """Set the maximum on-screen polyline simplification error"""
+
     @overload
     def circle(self, pos: Sequence[float]) -> None:
         """Draw an circle at position pos"""
@@ -144,10 +463,32 @@ class RenderBuffer:
     def circle(
         self,
         points: Annotated[
-            NDArray[numpy.float32], dict(shape=(None, 3), order="C", device="cpu")
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
         ],
+        colors: Annotated[
+            NDArray, dict(shape=(None, 4), device="cpu", writable=False)
+        ]
+        | None = None,
+        sizes: Annotated[
+            NDArray, dict(shape=(None,), device="cpu", writable=False)
+        ]
+        | None = None,
     ) -> None:
-        """Draw multiple circle at given positions"""
+        """
+        Draw multiple circles at given positions, with optional (N, 4) colors and (N,) sizes per circle
+        """
+
+    def reserve_points(self, n: int) -> Reservation:
+        """Reserve n points to fill in place, see Reservation"""
+
+    def reserve_circles(self, n: int) -> Reservation:
+        """Reserve n circles to fill in place, see Reservation"""
+
+    def reserve_lines(self, n: int) -> Reservation:
+        """Reserve n separate lines to fill in place, see Reservation"""
+
+    def reserve_line_to(self, n: int) -> Reservation:
+        """Reserve n consecutive line_to points to fill in place, see Reservation"""
 
     def color(self, c: Sequence[float]) -> None:
         """Set the current drawing color"""
@@ -163,6 +504,71 @@ class RenderBuffer:
     ) -> None:
         """Add an instance with given position, rotation and scale"""
 
+    @overload
+    def add_instances(
+        self,
+        transforms: Annotated[
+            NDArray[numpy.float32],
+            dict(shape=(None, 4, 4), order="C", device="cpu", writable=False),
+        ],
+    ) -> None:
+        """Add an instance for every row-major (4, 4) transform matrix"""
+
+    @overload
+    def add_instances(
+        self,
+        positions: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ],
+        rotations: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ]
+        | None = None,
+        scales: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ]
+        | None = None,
+    ) -> None:
+        """
+        Add an instance for every position, with optional rotations and scales
+        """
+
+    @overload
+    def set_instances(
+        self,
+        transforms: Annotated[
+            NDArray[numpy.float32],
+            dict(shape=(None, 4, 4), order="C", device="cpu", writable=False),
+        ],
+        first: int = 0,
+    ) -> None:
+        """
+        Overwrite the instances from first on with row-major (4, 4) transform matrices
+        """
+
+    @overload
+    def set_instances(
+        self,
+        positions: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ],
+        rotations: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ]
+        | None = None,
+        scales: Annotated[
+            NDArray, dict(shape=(None, 3), device="cpu", writable=False)
+        ]
+        | None = None,
+        first: int = 0,
+    ) -> None:
+        """
+        Overwrite the instances from first on with positions and optional rotations and scales
+        """
+
+    def instance_count(self) -> int:
+        """Number of instances, including the initial identity instance"""
+
     def save(self) -> None:
         """Save the current render buffer state"""
 